@@ -0,0 +1,76 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include "animator.hpp"
+#include "constants.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+
+
+Animator::Animator(ChangedCallback onChanged_)
+        : onChanged(onChanged_), tiles(nullptr), next(0), stepMs(1) {
+    timer.Bind(wxEVT_TIMER, [&](wxTimerEvent&) { onTimer(); });
+}
+
+
+// Shows moves on tiles at one per stepMs; onDone is called after the last
+// one (or immediately if there are none)
+void Animator::start(Grid* tiles_, const TileMoves& moves_, int stepMs_,
+                     Callback onDone_) {
+    finish();
+    tiles = tiles_;
+    moves = moves_;
+    next = 0;
+    stepMs = std::max(1, stepMs_);
+    onDone = onDone_;
+    if (moves.empty())
+        finish();
+    else {
+        stopWatch.Start();
+        timer.Start(FRAME_MS);
+    }
+}
+
+
+// Jumps to the end of the animation
+void Animator::finish() {
+    if (!isRunning())
+        return;
+    advance(moves.size());
+}
+
+
+// Abandons the animation without calling onDone
+void Animator::stop() {
+    timer.Stop();
+    tiles = nullptr;
+    moves.clear();
+    onDone = nullptr;
+}
+
+
+void Animator::onTimer() {
+    if (isRunning())
+        advance(static_cast<size_t>(stopWatch.Time() / stepMs) + 1);
+}
+
+
+void Animator::advance(size_t due) {
+    TRACE_SCOPE("animator/advance");
+    due = std::min(due, moves.size());
+    for (; next < due; ++next) {
+        const auto& move = moves[next];
+        tiles->at(move.to.x, move.to.y) = tiles->at(move.from.x,
+                                                    move.from.y);
+        tiles->at(move.from.x, move.from.y) = NO_COLOR;
+        onChanged(move.from);
+        onChanged(move.to);
+    }
+    if (next < moves.size())
+        return;
+    auto done = onDone;
+    stop();
+    if (done)
+        done();
+}
@@ -0,0 +1,49 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    Plays an engine move list back onto a view's Grid from a wxTimer so
+    that the event loop never blocks. Each frame applies every step that
+    is due by then, so if frames arrive late steps are coalesced rather
+    than the animation falling behind. Only the cells that change are
+    reported, so the view can repaint just those.
+*/
+
+#include "engine.hpp"
+
+#include <wx/wxprec.h>
+#ifndef WX_PRECOMP
+    #include <wx/wx.h>
+#endif
+#include <wx/stopwatch.h>
+
+#include <functional>
+
+
+class Animator {
+public:
+    using Callback = std::function<void()>;
+    using ChangedCallback = std::function<void(const Point&)>;
+
+    explicit Animator(ChangedCallback onChanged);
+
+    void start(Grid* tiles, const TileMoves& moves, int stepMs,
+               Callback onDone);
+    void finish();
+    void stop();
+    bool isRunning() const { return tiles != nullptr; }
+
+private:
+    void onTimer();
+    void advance(size_t due);
+
+    ChangedCallback onChanged;
+    Callback onDone;
+    Grid* tiles;
+    TileMoves moves;
+    size_t next;
+    int stepMs;
+    wxStopWatch stopWatch;
+    wxTimer timer;
+};
@@ -3,16 +3,24 @@
 
 #include "artprovider.hpp"
 #include "mainwindow.hpp"
+#include "trace.hpp"
 
 #include <wx/wxprec.h>
 #ifndef WX_PRECOMP
     #include <wx/wx.h>
 #endif
+#include <wx/cmdline.h>
 
 
 class Application : public wxApp {
 public:
     virtual bool OnInit();
+    virtual int OnExit();
+    virtual void OnInitCmdLine(wxCmdLineParser& parser);
+    virtual bool OnCmdLineParsed(wxCmdLineParser& parser);
+
+private:
+    wxString traceFilename; // Only traced from startup if given
 };
 
 
@@ -20,6 +28,8 @@ wxIMPLEMENT_APP(Application);
 
 
 bool Application::OnInit() {
+    if (!wxApp::OnInit()) // Parses the command line
+        return false;
     SetAppName("Gravitate");
     SetVendorName("qtrac.eu");
     wxArtProvider::Push(new ArtProvider);
@@ -27,3 +37,26 @@ bool Application::OnInit() {
     window->Show(true);
     return true;
 }
+
+
+int Application::OnExit() {
+    if (!traceFilename.IsEmpty()) {
+        stopTrace();
+        writeTrace(traceFilename.ToStdString());
+    }
+    return wxApp::OnExit();
+}
+
+
+void Application::OnInitCmdLine(wxCmdLineParser& parser) {
+    wxApp::OnInitCmdLine(parser);
+    parser.AddOption("", "trace", "record where the time goes and save it "
+                     "as Chrome trace JSON in the given file on quitting");
+}
+
+
+bool Application::OnCmdLineParsed(wxCmdLineParser& parser) {
+    if (parser.Found("trace", &traceFilename))
+        startTrace();
+    return wxApp::OnCmdLineParsed(parser);
+}
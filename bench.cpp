@@ -0,0 +1,434 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    Benchmarks: scons gravitate-bench && ./gravitate-bench [filter]
+    Only benchmarks whose names contain filter are run. Boards are dealt
+    from fixed seeds so runs are comparable from commit to commit. Each
+    result is printed as a CSV line:
+        name,columns,rows,colors,iterations,ns_per_iteration
+    move/sequence also checks that showing a move takes the same timer
+    events however many moves came before it; if not, it says why and
+    the exit status is 1.
+*/
+
+#include "boardrenderer.hpp"
+#include "engine.hpp"
+#include "movesequence.hpp"
+#include "scan.hpp"
+#include "tilecache.hpp"
+
+#include <wx/dcmemory.h>
+#include <wx/init.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const unsigned SEED = 1;
+const long WORK = 20000000; // Roughly how many cells each benchmark visits
+
+const int SIZES[][2]{{9, 9}, {30, 30}, {100, 100}, {300, 300},
+                     {1000, 1000}};
+const int COLORS[]{4, 7};
+const int RENDER_WIDTH = 1280; // Pixels for render/frame
+const int RENDER_HEIGHT = 960;
+const long SEQUENCE_MOVES = 10000; // Moves shown by move/sequence
+
+wxUint32 sink; // Stops the compiler optimizing the work away
+const char* filter = "";
+
+
+struct Config {
+    int columns;
+    int rows;
+    int colors;
+};
+
+
+bool wanted(const char* name) {
+    return std::strstr(name, filter) != nullptr;
+}
+
+
+void report(const char* name, const Config& config, long iterations,
+            double ns) {
+    std::printf("%s,%d,%d,%d,%ld,%.1f\n", name, config.columns,
+                config.rows, config.colors, iterations, ns / iterations);
+    std::fflush(stdout);
+}
+
+
+template<typename Fn>
+void bench(const char* name, const Config& config, long iterations,
+           Fn fn) {
+    if (!wanted(name))
+        return;
+    const auto start = Clock::now();
+    for (long i = 0; i < iterations; ++i)
+        fn(i);
+    const std::chrono::duration<double, std::nano> elapsed =
+        Clock::now() - start;
+    report(name, config, iterations, elapsed.count());
+}
+
+
+// Enough iterations to visit about WORK cells, but at least a few
+long iterationsFor(const Config& config, long minimum=3) {
+    return std::max(minimum, WORK / (static_cast<long>(config.columns) *
+                                     config.rows));
+}
+
+
+using ColorMap = std::unordered_map<wxUint32, wxUint32>;
+
+
+const ColorMap& legacyColorMap() {
+    static ColorMap colors;
+    if (colors.empty())
+        for (const auto& entry: PALETTE)
+            colors[entry.dark] = entry.light;
+    return colors;
+}
+
+
+// What each tile cost before the palette table: a copy of the whole color
+// map, a hash lookup, and lightness changes
+ColorPair legacyColorPair(const wxColour& color, bool gameOver) {
+    ColorPair colorPair;
+    auto colors = legacyColorMap();
+    if (colors.find(color.GetRGBA()) == colors.end()) { // not found
+        colorPair.light = color;                        // ∴ dimmed
+        colorPair.dark = color.ChangeLightness(70);
+    }
+    else {
+        colorPair.light = wxColour(colors[color.GetRGBA()]);
+        colorPair.dark = color;
+        if (gameOver) {
+            colorPair.light = colorPair.light.ChangeLightness(85);
+            colorPair.dark = colorPair.dark.ChangeLightness(85);
+        }
+    }
+    return colorPair;
+}
+
+
+// The palette cost of painting every tile of a 30 x 30 board once
+void benchPalette() {
+    const int tileCount = 30 * 30;
+    const int maxColors = 4;
+    const long paints = 200;
+    Randomizer randomizer(1);
+    std::vector<int> cells;
+    for (int i = 0; i < tileCount; ++i)
+        cells.push_back(randomizer.between(1, maxColors));
+    const PaletteIndexes indexes{0, 1, 2, 3};
+    std::vector<wxColour> colors;
+    for (const int cell: cells)
+        colors.push_back(wxColour(PALETTE[indexes[cell - 1]].dark));
+    const Config config{30, 30, maxColors};
+    bench("palette/map_per_tile", config, paints, [&](long) {
+        for (const auto& color: colors)
+            sink += legacyColorPair(color, false).light.GetRGBA();
+    });
+    TilePalette palette;
+    palette.reset(indexes);
+    bench("palette/table_per_tile", config, paints, [&](long) {
+        for (const int cell: cells)
+            sink += palette.get(cell, TileLook::Normal).light.GetRGBA();
+    });
+}
+
+// Engine::adjoining() (formerly populateAdjoining) for every legal group
+void benchAdjoining(const Config& config) {
+    Engine engine(SEED);
+    engine.newGame(config.columns, config.rows, config.colors);
+    Points moves;
+    engine.legalMoves(moves);
+    if (moves.empty())
+        return;
+    bench("engine/adjoining", config, iterationsFor(config, 100),
+          [&](long i) {
+        sink += engine.adjoining(moves[i % moves.size()]).size(); });
+}
+
+
+// The scan behind the old checkTiles(): the game state itself is now
+// kept up to date by Components' counters, so it costs nothing to read
+void benchLegalMoves(const Config& config) {
+    Engine engine(SEED);
+    engine.newGame(config.columns, config.rows, config.colors);
+    Points moves;
+    bench("engine/legal_moves", config, iterationsFor(config),
+          [&](long) {
+        moves.clear();
+        engine.legalMoves(moves);
+        sink += moves.size() + engine.legalMoveCount() +
+                static_cast<int>(engine.state());
+    });
+}
+
+
+// Each whole-board scan with every kernel the CPU supports. any_legal is
+// timed on a checkerboard, which has no legal cell, so it reads the
+// whole board as it would for a lost game.
+void benchScans(const Config& config) {
+    Engine engine(SEED);
+    engine.newGame(config.columns, config.rows, config.colors);
+    Grid checkerboard;
+    checkerboard.reset(config.columns, config.rows);
+    for (int y = 0; y < config.rows; ++y)
+        for (int x = 0; x < config.columns; ++x)
+            checkerboard.at(x, y) = static_cast<Cell>((x + y) % 2 + 1);
+    const auto iterations = iterationsFor(config);
+    for (const auto kernel: {ScanKernel::Scalar, ScanKernel::Sse2,
+                             ScanKernel::Avx2}) {
+        if (!isSupported(kernel))
+            continue;
+        const std::string suffix = std::string("/") + kernelName(kernel);
+        bench(("scan/any_legal" + suffix).c_str(), config, iterations,
+              [&](long) { sink += hasLegalCell(checkerboard, kernel); });
+        bench(("scan/legal_cells" + suffix).c_str(), config, iterations,
+              [&](long) { sink += legalCellCount(engine.grid(), kernel); });
+        bench(("scan/color_histogram" + suffix).c_str(), config,
+              iterations, [&](long) {
+            sink += colorHistogram(engine.grid(), kernel)[1]; });
+    }
+}
+
+
+void benchNewGame(const Config& config) {
+    Engine engine(SEED);
+    bench("engine/new_game", config, iterationsFor(config), [&](long i) {
+        engine.newGame(config.columns, config.rows, config.colors,
+                       SEED + static_cast<unsigned>(i));
+        sink += engine.hash();
+    });
+}
+
+
+// Plays largest-group-first games timing only the moves. apply() is the
+// removal, moveTiles() (whose inner step is nearestToMiddle()), the
+// relabelling, and the game over check; engine/settle_per_tile_move is
+// the same time per tile moved.
+void benchApply(const Config& config) {
+    if (!wanted("engine/apply") && !wanted("engine/settle"))
+        return;
+    const long cellBudget = WORK / 4;
+    Engine engine(SEED);
+    Points moves;
+    long applies = 0;
+    long tileMoves = 0;
+    long visited = 0;
+    double ns = 0;
+    for (unsigned game = 0; visited < cellBudget || applies < 3; ++game) {
+        engine.newGame(config.columns, config.rows, config.colors,
+                       SEED + game);
+        while (engine.state() == GameState::Playing &&
+                (visited < cellBudget || applies < 3)) {
+            moves.clear();
+            engine.legalMoves(moves);
+            const auto move = *std::max_element(
+                moves.cbegin(), moves.cend(),
+                [&](const Point& a, const Point& b) {
+                    return engine.groupSize(a) < engine.groupSize(b); });
+            const auto start = Clock::now();
+            const auto result = engine.apply(move);
+            const std::chrono::duration<double, std::nano> elapsed =
+                Clock::now() - start;
+            ns += elapsed.count();
+            ++applies;
+            tileMoves += result.moves.size();
+            visited += result.removed.size() + result.moves.size() +
+                       config.columns; // So huge boards stop sooner
+        }
+    }
+    if (wanted("engine/apply"))
+        report("engine/apply", config, applies, ns);
+    if (wanted("engine/settle"))
+        report("engine/settle_per_tile_move", config,
+               std::max(1L, tileMoves), ns);
+}
+
+
+// Plays largest-first games and then takes every move back
+void benchUndo(const Config& config) {
+    if (!wanted("engine/undo"))
+        return;
+    const long cellBudget = WORK / 4;
+    Engine engine(SEED);
+    Points moves;
+    long undos = 0;
+    long visited = 0;
+    double ns = 0;
+    for (unsigned game = 0; visited < cellBudget || undos < 3; ++game) {
+        engine.newGame(config.columns, config.rows, config.colors,
+                       SEED + game);
+        while (engine.state() == GameState::Playing &&
+                visited < cellBudget) {
+            moves.clear();
+            engine.legalMoves(moves);
+            const auto move = *std::max_element(
+                moves.cbegin(), moves.cend(),
+                [&](const Point& a, const Point& b) {
+                    return engine.groupSize(a) < engine.groupSize(b); });
+            const auto result = engine.apply(move, false);
+            visited += result.removed.size() + result.moves.size() +
+                       config.columns;
+        }
+        const auto start = Clock::now();
+        while (engine.undo())
+            ++undos;
+        const std::chrono::duration<double, std::nano> elapsed =
+            Clock::now() - start;
+        ns += elapsed.count();
+        sink += engine.score();
+    }
+    report("engine/undo", config, undos, ns);
+}
+
+
+// What onPaint() does for a full repaint, into an offscreen bitmap
+void benchPaint(const Config& config) {
+    if (!wanted("paint/full_board"))
+        return;
+    Engine engine(SEED);
+    engine.newGame(config.columns, config.rows, config.colors);
+    const int size = std::max(MIN_TILE_SIZE,
+                              900 / std::max(config.columns, config.rows));
+    wxBitmap bitmap(size * config.columns, size * config.rows);
+    wxMemoryDC dc(bitmap);
+    TileCache tileCache;
+    tileCache.setPalette(engine.palette());
+    tileCache.setSize(size, size);
+    const wxRect cells(0, 0, config.columns, config.rows);
+    tileCache.paint(dc, engine.grid(), cells, wxPoint(), false, Point());
+    bench("paint/full_board", config, iterationsFor(config, 5) / 50 + 1,
+          [&](long) {
+        tileCache.paint(dc, engine.grid(), cells, wxPoint(), false,
+                        Point());
+    });
+}
+
+
+// A whole frame as the window paints it, at a fixed target size so that
+// frames per second (1e9 / ns_per_iteration) compare across board sizes,
+// and a whole-board PNG-ready image as export and gravitate-render make
+void benchRender(const Config& config) {
+    if (!wanted("render/"))
+        return;
+    Engine engine(SEED);
+    engine.newGame(config.columns, config.rows, config.colors);
+    BoardRenderer renderer;
+    renderer.setPalette(engine.palette());
+    BoardView view;
+    view.size = wxSize(RENDER_WIDTH, RENDER_HEIGHT);
+    const auto size = fitTileSize(view.size, config.columns, config.rows);
+    view.tileWidth = static_cast<int>(size.width);
+    view.tileHeight = static_cast<int>(size.height);
+    wxBitmap bitmap(view.size.x, view.size.y);
+    wxMemoryDC dc(bitmap);
+    renderer.paint(dc, engine.grid(), view);
+    const long frames = iterationsFor(config, 5) / 50 + 1;
+    bench("render/frame", config, frames, [&](long) {
+        renderer.paint(dc, engine.grid(), view);
+    });
+    const auto whole = wholeBoardView(engine.grid(), MIN_TILE_SIZE);
+    bench("render/image", config, std::min(frames, 20L), [&](long) {
+        sink += renderer.render(engine.grid(), whole).GetWidth();
+    });
+}
+
+
+// Shows thousands of moves, one game after another, through one
+// MoveSequence as a long session would, stepping each delay with
+// notify() since there is no event loop. Every notify() must run exactly
+// one handler, and every move must take two of them and leave the shown
+// tiles the same as the engine's.
+bool benchMoveSequence() {
+    const Config config{30, 30, 4};
+    Engine engine(SEED);
+    engine.setUndoable(false);
+    Grid tiles;
+    long changes = 0;
+    long done = 0;
+    MoveSequence sequence([&](const Point&) { ++changes; },
+                          [&]() { ++done; });
+    Points legal;
+    unsigned seed = SEED;
+    long moves = 0;
+    double ns = 0;
+    while (moves < SEQUENCE_MOVES) {
+        engine.newGame(config.columns, config.rows, config.colors, seed++);
+        tiles = engine.grid();
+        while (engine.state() == GameState::Playing &&
+               moves < SEQUENCE_MOVES) {
+            engine.legalMoves(legal);
+            const auto start = Clock::now();
+            sequence.start(&tiles, engine.apply(legal.front()), 0);
+            const long handled = sequence.handled();
+            sequence.notify(); // Dimming's delay ends
+            const bool once = sequence.handled() == handled + 1;
+            sequence.notify(); // Deleting's delay ends
+            sequence.finishAnimation();
+            const std::chrono::duration<double, std::nano> elapsed =
+                Clock::now() - start;
+            ns += elapsed.count();
+            ++moves;
+            const char* problem = nullptr;
+            if (!once || sequence.handled() != handled + 2)
+                problem = "timer handlers have piled up";
+            else if (sequence.isRunning() || done != moves)
+                problem = "the move didn't finish";
+            else if (!(tiles == engine.grid()))
+                problem = "the tiles shown differ from the engine's";
+            if (problem) {
+                std::fprintf(stderr, "move/sequence: move %ld: %s\n", moves,
+                             problem);
+                return false;
+            }
+        }
+    }
+    sink += changes;
+    report("move/sequence", config, moves, ns);
+    return true;
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[]) {
+    wxInitializer initializer;
+    if (!initializer.IsOk()) {
+        std::fprintf(stderr, "failed to initialize wxWidgets\n");
+        return 1;
+    }
+    if (argc > 1)
+        filter = argv[1];
+    std::printf("name,columns,rows,colors,iterations,ns_per_iteration\n");
+    for (const auto& size: SIZES)
+        for (const int colors: COLORS) {
+            const Config config{size[0], size[1], colors};
+            benchNewGame(config);
+            benchAdjoining(config);
+            benchLegalMoves(config);
+            benchScans(config);
+            benchApply(config);
+            benchUndo(config);
+            benchPaint(config);
+            benchRender(config);
+        }
+    if (wanted("palette"))
+        benchPalette();
+    const bool ok = !wanted("move/sequence") || benchMoveSequence();
+    std::fprintf(stderr, "checksum %u\n", sink);
+    return ok ? 0 : 1;
+}
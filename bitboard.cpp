@@ -0,0 +1,81 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include "bitboard.hpp"
+
+#include <algorithm>
+
+
+void Bitboard::reset(int columns, int rows) {
+    columns_ = columns;
+    rows_ = rows;
+    stride = (columns + WORD_BITS - 1) / WORD_BITS;
+    words.assign(static_cast<size_t>(stride) * rows, 0);
+}
+
+
+int Bitboard::count() const {
+    int total = 0;
+    for (const auto word: words)
+        total += __builtin_popcountll(word);
+    return total;
+}
+
+
+// Returns the connected group of set bits that includes (x, y), found by
+// growing the group a word at a time until it stops changing. Only the
+// rows the group has reached (plus one either side) are visited.
+Bitboard Bitboard::group(int x, int y) const {
+    Bitboard result(columns_, rows_);
+    if (!test(x, y))
+        return result;
+    result.set(x, y);
+    int top = y;
+    int bottom = y;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        const int first = std::max(0, top - 1);
+        const int last = std::min(rows_ - 1, bottom + 1);
+        for (int pass = 0; pass < 2; ++pass) // Downwards then upwards
+            for (int k = first; k <= last; ++k) {
+                const int row = pass ? last - (k - first) : k;
+                for (int w = 0; w < stride; ++w) {
+                    const int i = row * stride + w;
+                    const Word mask = words[i];
+                    const Word old = result.words[i];
+                    Word grown = result.spread(row, w) & mask;
+                    Word previous;
+                    do { // Fill along the row within the word
+                        previous = grown;
+                        grown |= ((grown << 1) | (grown >> 1)) & mask;
+                    } while (grown != previous);
+                    if (grown != old) {
+                        result.words[i] = grown;
+                        changed = true;
+                        top = std::min(top, row);
+                        bottom = std::max(bottom, row);
+                    }
+                }
+            }
+    }
+    return result;
+}
+
+
+// Returns the word at (y, w) with every bit also set in each of its four
+// neighbouring positions
+Word Bitboard::spread(int y, int w) const {
+    const int i = y * stride + w;
+    const Word word = words[i];
+    Word result = word | (word << 1) | (word >> 1);
+    if (w > 0)
+        result |= words[i - 1] >> (WORD_BITS - 1);
+    if (w + 1 < stride)
+        result |= words[i + 1] << (WORD_BITS - 1);
+    if (y > 0)
+        result |= words[i - stride];
+    if (y + 1 < rows_)
+        result |= words[i + stride];
+    return result;
+}
@@ -0,0 +1,61 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    One bit per board cell. Each row occupies a whole number of 64-bit
+    words so that boards of any size work; the unused high bits of a row's
+    last word are always 0. The engine keeps one Bitboard per color.
+*/
+
+#include <cstdint>
+#include <vector>
+
+
+using Word = std::uint64_t;
+
+const int WORD_BITS = 64;
+
+
+class Bitboard {
+public:
+    Bitboard(int columns=0, int rows=0) { reset(columns, rows); }
+
+    void reset(int columns, int rows);
+
+    int columns() const { return columns_; }
+    int rows() const { return rows_; }
+
+    bool test(int x, int y) const {
+        return (words[offset(x, y)] >> (x % WORD_BITS)) & 1;
+    }
+    void set(int x, int y) {
+        words[offset(x, y)] |= Word(1) << (x % WORD_BITS);
+    }
+    void clear(int x, int y) {
+        words[offset(x, y)] &= ~(Word(1) << (x % WORD_BITS));
+    }
+
+    int count() const;
+    Bitboard group(int x, int y) const;
+
+    template<typename Fn> void forEach(Fn fn) const {
+        for (int y = 0; y < rows_; ++y)
+            for (int w = 0; w < stride; ++w) {
+                Word word = words[y * stride + w];
+                while (word) {
+                    fn(w * WORD_BITS + __builtin_ctzll(word), y);
+                    word &= word - 1;
+                }
+            }
+    }
+
+private:
+    int offset(int x, int y) const { return y * stride + x / WORD_BITS; }
+    Word spread(int y, int w) const;
+
+    int columns_;
+    int rows_;
+    int stride; // Words per row
+    std::vector<Word> words;
+};
@@ -0,0 +1,130 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include "boardrenderer.hpp"
+#include "trace.hpp"
+
+#include <wx/dcmemory.h>
+#include <wx/graphics.h>
+#include <wx/imagpng.h>
+
+#include <algorithm>
+#include <cmath>
+
+
+// Tiles are a whole number of pixels in size so that each has its own
+// exact rectangle to repaint; any spare pixels are at the right and bottom.
+// If the board can't fit with tiles of at least MIN_TILE_SIZE it is drawn
+// at that size and must be panned.
+TileSize fitTileSize(const wxSize& size, int columns, int rows) {
+    const double minimum = MIN_TILE_SIZE;
+    return {std::max(minimum, std::floor(size.x /
+                     static_cast<double>(columns))),
+            std::max(minimum, std::floor(size.y /
+                     static_cast<double>(rows)))};
+}
+
+
+// The whole board with square tiles, shrunk if need be to keep the image
+// within IMAGE_SIZE_MAX pixels a side
+BoardView wholeBoardView(const Grid& tiles, int tileSize) {
+    BoardView view;
+    const int longest = std::max(tiles.columns(), tiles.rows());
+    view.tileWidth = view.tileHeight = std::max(
+        1, std::min(tileSize, IMAGE_SIZE_MAX / std::max(1, longest)));
+    view.size = wxSize(view.tileWidth * tiles.columns(),
+                       view.tileHeight * tiles.rows());
+    return view;
+}
+
+
+bool savePng(const wxImage& image, const wxString& filename) {
+    if (!wxImage::FindHandler(wxBITMAP_TYPE_PNG))
+        wxImage::AddHandler(new wxPNGHandler);
+    return image.IsOk() && image.SaveFile(filename, wxBITMAP_TYPE_PNG);
+}
+
+
+void BoardRenderer::paint(wxDC& dc, const Grid& tiles,
+                          const BoardView& view) {
+    paintMargins(dc, tiles, view);
+    paintTiles(dc, tiles, view, wxRect(view.size));
+    paintGameOver(dc, view);
+}
+
+
+// Fills whatever of the target is to the right of or below the board
+void BoardRenderer::paintMargins(wxDC& dc, const Grid& tiles,
+                                 const BoardView& view) {
+    const int boardRight = view.tileWidth * tiles.columns() - view.origin.x;
+    const int boardBottom = view.tileHeight * tiles.rows() - view.origin.y;
+    dc.SetPen(*wxTRANSPARENT_PEN);
+    dc.SetBrush(wxBrush(BACKGROUND_COLOR));
+    if (boardRight < view.size.x)
+        dc.DrawRectangle(boardRight, 0, view.size.x - boardRight,
+                         view.size.y);
+    if (boardBottom < view.size.y)
+        dc.DrawRectangle(0, boardBottom, view.size.x,
+                         view.size.y - boardBottom);
+}
+
+
+// Only the tiles that intersect update (in target pixels) are drawn
+void BoardRenderer::paintTiles(wxDC& dc, const Grid& tiles,
+                               const BoardView& view, const wxRect& update) {
+    if (tiles.empty())
+        return;
+    const int width = view.tileWidth;
+    const int height = view.tileHeight;
+    tileCache.setSize(width, height);
+    const int x1 = std::max(0, (update.x + view.origin.x) / width);
+    const int y1 = std::max(0, (update.y + view.origin.y) / height);
+    const int x2 = std::min(tiles.columns() - 1,
+                            (update.GetRight() + view.origin.x) / width);
+    const int y2 = std::min(tiles.rows() - 1,
+                            (update.GetBottom() + view.origin.y) / height);
+    if (x1 <= x2 && y1 <= y2)
+        tileCache.paint(dc, tiles, wxRect(wxPoint(x1, y1), wxPoint(x2, y2)),
+                        view.origin, view.gameOver, view.focus);
+}
+
+
+// Centred on the target, whatever part of the board is in view
+void BoardRenderer::paintGameOver(wxDC& dc, const BoardView& view) {
+    if (!view.userWon && !view.gameOver)
+        return;
+    auto gc = wxGraphicsContext::Create(dc);
+    if (!gc)
+        return;
+    const wxString text(view.userWon ? "You Won!" : "Game Over");
+    wxFont font(36, wxFONTFAMILY_DECORATIVE, wxFONTSTYLE_NORMAL,
+                wxFONTWEIGHT_BOLD);
+    gc->SetFont(font, *wxWHITE);
+    double width;
+    double height;
+    double descent;
+    double leading;
+    gc->GetTextExtent(text, &width, &height, &descent, &leading);
+    const auto x = (view.size.x - width) / 2;
+    const auto y = (view.size.y / 2) - (height + descent + leading);
+    gc->DrawText(text, x - 2, y - 3);
+    gc->SetFont(font, *wxBLACK);
+    gc->DrawText(text, x, y);
+    wxColour color(view.userWon ? 0xFF0000BB : 0xFF009900);
+    gc->SetFont(font, color);
+    gc->DrawText(text, x - 1, y - 2);
+    delete gc;
+}
+
+
+// Draws into an offscreen bitmap, so no window (or, with a virtual
+// display, no screen) is needed
+wxImage BoardRenderer::render(const Grid& tiles, const BoardView& view) {
+    TRACE_SCOPE("renderer/render");
+    wxBitmap bitmap(std::max(1, view.size.x), std::max(1, view.size.y));
+    {
+        wxMemoryDC dc(bitmap);
+        paint(dc, tiles, view);
+    }
+    return bitmap.ConvertToImage();
+}
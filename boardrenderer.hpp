@@ -0,0 +1,59 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    Draws a board, or the part of it in view, onto any wxDC. The window
+    paints through it, and so do image export, gravitate-render and the
+    rendering benchmarks, which draw into a wxMemoryDC with no window at
+    all. Tiles are blitted from a TileCache, so only the first frame at a
+    new tile size pays for rendering the tiles.
+*/
+
+#include "boardutil.hpp"
+#include "tilecache.hpp"
+
+#include <wx/wxprec.h>
+#ifndef WX_PRECOMP
+    #include <wx/wx.h>
+#endif
+
+
+const int IMAGE_SIZE_MAX = 8192; // Pixels a side for a whole-board image
+
+
+// What to draw and where: the board pixel at origin is drawn at the
+// target's top-left
+struct BoardView {
+    wxSize size; // The target's size in pixels
+    int tileWidth = MIN_TILE_SIZE;
+    int tileHeight = MIN_TILE_SIZE;
+    wxPoint origin;
+    Point focus;
+    bool gameOver = false;
+    bool userWon = false;
+};
+
+
+TileSize fitTileSize(const wxSize& size, int columns, int rows);
+BoardView wholeBoardView(const Grid& tiles, int tileSize);
+bool savePng(const wxImage& image, const wxString& filename);
+
+
+class BoardRenderer {
+public:
+    void setPalette(const PaletteIndexes& indexes) {
+        tileCache.setPalette(indexes);
+    }
+    void clear() { tileCache.clear(); }
+
+    void paint(wxDC& dc, const Grid& tiles, const BoardView& view);
+    void paintMargins(wxDC& dc, const Grid& tiles, const BoardView& view);
+    void paintTiles(wxDC& dc, const Grid& tiles, const BoardView& view,
+                    const wxRect& update);
+    void paintGameOver(wxDC& dc, const BoardView& view);
+    wxImage render(const Grid& tiles, const BoardView& view);
+
+private:
+    TileCache tileCache;
+};
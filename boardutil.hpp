@@ -3,6 +3,8 @@
 // License: GPLv3
 
 #include "constants.hpp"
+#include "engine.hpp"
+#include "palette.hpp"
 
 #include <wx/wxprec.h>
 #ifndef WX_PRECOMP
@@ -10,13 +12,7 @@
 #endif
 #include <wx/graphics.h>
 
-#include <random>
-#include <unordered_map>
-#include <unordered_set>
-#include <vector>
 
-
-const int INVALID_POS = -1;
 const auto BACKGROUND_COLOR = wxColour(0xFFFFFEE0);
 
 
@@ -32,41 +28,24 @@ struct TileSize {
 };
 
 
-struct Point {
-    Point(int x_=INVALID_POS, int y_=INVALID_POS) : x(x_), y(y_) {}
-
-    bool isValid() const { return x != INVALID_POS && y != INVALID_POS; }
+enum class TileLook { Normal, Dimmed, GameOver, Hinted };
 
-    int x;
-    int y;
-};
+const int TILE_LOOKS = 4;
 
 
-bool operator==(const Point& a, const Point& b);
+using Coords = double[COORDS_LEN][2];
 
 
-namespace std {
-    template<> struct hash<Point> {
-        size_t operator()(const Point& xy) const noexcept {
-            return std::hash<int>{}(xy.x) ^ (std::hash<int>{}(xy.y) << 1);
-        }
-    };
-}
+// Every pair of colors a tile can be drawn with, worked out once per game
+// and then looked up by color index
+class TilePalette {
+public:
+    void reset(const PaletteIndexes& indexes);
 
+    const ColorPair& get(int color, TileLook look) const {
+        return pairs[color][static_cast<int>(look)];
+    }
 
-using ColorMap = std::unordered_map<wxUint32, wxUint32>;
-using ColorVector = std::vector<wxColour>;
-using Coords = double[COORDS_LEN][2];
-using PointMap = std::unordered_map<Point, Point>;
-using PointSet = std::unordered_set<Point>;
-using Randomizer = std::default_random_engine;
-using Ripple = std::vector<int>;
-using TileRow = std::vector<wxColour>;
-using TileGrid = std::vector<TileRow>;
-
-
-ColorVector getColors(int, Randomizer&);
-ColorPair getColorPair(const wxColour&, bool);
-size_t colorCount();
-const ColorMap& colorMap();
-Ripple rippledRange(int limit, Randomizer& randomizer);
+private:
+    ColorPair pairs[MAX_COLOR_INDEX + 1][TILE_LOOKS];
+};
@@ -2,63 +2,179 @@
 // License: GPLv3
 
 #include "boardwidget.hpp"
+#include "replay.hpp"
+#include "settings.hpp"
+#include "snapshot.hpp"
+#include "trace.hpp"
+#include "util.hpp"
 
-#include <wx/config.h>
+#include <wx/datetime.h>
 #include <wx/dcclient.h>
-#include <wx/utils.h>
+#include <wx/filename.h>
+#include <wx/stdpaths.h>
 
 #include <chrono>
+#include <cmath>
 #include <functional>
-#include <memory>
 
 
 wxDEFINE_EVENT(SCORE_EVENT, wxCommandEvent);
 wxDEFINE_EVENT(GAME_OVER_EVENT, wxCommandEvent);
+wxDEFINE_EVENT(HINT_EVENT, wxCommandEvent);
 
 
 BoardWidget::BoardWidget(wxWindow* parent)
-        : wxWindow(parent, wxID_ANY), score(0), gameOver(true),
-          userWon(false), drawing(false), columns(COLUMNS_DEFAULT),
-          rows(ROWS_DEFAULT), maxColors(MAX_COLORS_DEFAULT),
-          delayMs(DELAY_MS_DEFAULT) {
+        : wxWindow(parent, wxID_ANY), gameOver(true), userWon(false),
+          recorded(true), provenSolvable(false), drawing(false),
+          delayMs(DELAY_MS_DEFAULT), hintMs(HINT_MS_DEFAULT), zoom(0),
+          engine(std::chrono::system_clock::now().time_since_epoch()
+                 .count()),
+          sequence([&](const Point& point) { drawTile(point); },
+                   [&]() { finishMove(); }),
+          dealer(DEALER_THREADS) {
     SetDoubleBuffered(true);
-    const auto seed = std::chrono::system_clock::now().time_since_epoch()
-        .count();
-    randomizer.seed(seed);
     Bind(wxEVT_LEFT_DOWN, &BoardWidget::onClick, this);
+    Bind(wxEVT_MOUSEWHEEL, &BoardWidget::onWheel, this);
+    Bind(wxEVT_MIDDLE_DOWN, &BoardWidget::onPanStart, this);
+    Bind(wxEVT_RIGHT_DOWN, &BoardWidget::onPanStart, this);
+    Bind(wxEVT_MOTION, &BoardWidget::onPan, this);
     Bind(wxEVT_CHAR_HOOK, &BoardWidget::onChar, this);
     Bind(wxEVT_PAINT, &BoardWidget::onPaint, this);
-    Bind(wxEVT_SIZE, [&](wxSizeEvent&) { draw(); });
+    settingsId = Settings::get().listen([&](SettingsChange change) {
+        if (change == SettingsChange::Board) {
+            readTimings();
+            fillDeals();
+        }
+    });
+    readTimings();
+    dealer.load(dealsFilename().ToStdString());
+    fillDeals();
+    const auto dataDir = wxStandardPaths::Get().GetUserDataDir();
+    if (wxFileName::Mkdir(dataDir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL))
+        scoreDb.open(
+            wxFileName(dataDir, SCORE_LOG_FILE).GetFullPath().ToStdString(),
+            wxFileName(dataDir, SCORE_INDEX_FILE).GetFullPath()
+                .ToStdString());
+    hintTimer.Bind(wxEVT_TIMER, [&](wxTimerEvent&) { showHint(); });
+    Bind(wxEVT_SIZE, [&](wxSizeEvent&) { clampOrigin(); draw(); });
+#if wxCHECK_VERSION(3, 1, 3)
+    Bind(wxEVT_DPI_CHANGED, [&](wxDPIChangedEvent& event) {
+         renderer.clear(); draw(); event.Skip(); });
+#endif
+}
+
+
+void BoardWidget::newGame(std::optional<unsigned> seed) {
+    TRACE_SCOPE("board/newGame");
+    stopGame();
+    const auto& options = Settings::get().board();
+    provenSolvable = false;
+    if (!seed && options.solvableOnly) {
+        seed = dealer.take({options.columns, options.rows,
+                            options.maxColors});
+        provenSolvable = seed.has_value();
+    }
+    if (seed)
+        engine.newGame(options.columns, options.rows, options.maxColors,
+                       *seed);
+    else
+        engine.newGame(options.columns, options.rows, options.maxColors);
+    startGame(Point());
+    checkGameOver(engine.state()); // The deal may have no move to make
+}
+
+
+// Resumes the game that was in progress when the app was last closed;
+// returns false if there isn't one
+bool BoardWidget::resumeGame() {
+    TRACE_SCOPE("board/resumeGame");
+    stopGame();
+    Point focus;
+    if (!loadSnapshot(snapshotFilename(), engine, focus) ||
+            engine.state() != GameState::Playing)
+        return false;
+    startGame(engine.grid().contains(focus.x, focus.y) ? focus : Point());
+    return true;
+}
+
+
+// Called on close so that an unfinished game can be resumed; otherwise
+// any old snapshot is removed so that the next start deals a new game
+void BoardWidget::saveGame() {
+    TRACE_SCOPE("board/saveGame");
+    const auto filename = snapshotFilename();
+    if (gameOver || engine.state() != GameState::Playing) {
+        if (wxFileExists(filename))
+            wxRemoveFile(filename);
+    }
+    else if (wxFileName(filename).Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL))
+        saveSnapshot(filename.ToStdString(), engine, selected);
+    dealer.save(dealsFilename().ToStdString());
+}
+
+
+wxString BoardWidget::snapshotFilename() const {
+    return wxFileName(wxStandardPaths::Get().GetUserDataDir(),
+                      SNAPSHOT_FILE).GetFullPath();
+}
+
+
+wxString BoardWidget::dealsFilename() const {
+    return wxFileName(wxStandardPaths::Get().GetUserDataDir(),
+                      DEALS_FILE).GetFullPath();
 }
 
 
-void BoardWidget::newGame() {
+// Has solvable deals found in the background for the board in the
+// options, so that New never waits for the solver
+void BoardWidget::fillDeals() {
+    const auto& options = Settings::get().board();
+    if (options.solvableOnly)
+        dealer.fill({options.columns, options.rows, options.maxColors});
+}
+
+
+void BoardWidget::stopGame() {
+    sequence.stop();
+    hinter.cancel();
+    hintTimer.Stop();
+    hinted.clear();
+}
+
+
+// Shows the engine's newly dealt or resumed game
+void BoardWidget::startGame(const Point& focus) {
+    TRACE_SCOPE("board/startGame");
     gameOver = false;
     userWon = false;
-    score = 0;
-    selected.x = selected.y = INVALID_POS;
-    std::unique_ptr<wxConfig> config(new wxConfig(wxTheApp->GetAppName()));
-    config->Read(MAX_COLORS, &maxColors, MAX_COLORS_DEFAULT);
-    config->Read(COLUMNS, &columns, COLUMNS_DEFAULT);
-    config->Read(ROWS, &rows, ROWS_DEFAULT);
-    config->Read(DELAY_MS, &delayMs, DELAY_MS_DEFAULT);
-    const auto colors = getColors(maxColors, randomizer);
-    std::uniform_int_distribution<int> distribution(0, maxColors - 1);
-    tiles.clear();
-    for (int x = 0; x < columns; ++x) {
-        tiles.push_back(TileRow());
-        for (int y = 0; y < rows; ++y)
-            tiles[x].push_back(colors[distribution(randomizer)]);
-    }
+    recorded = false;
+    started = std::chrono::steady_clock::now();
+    selected = focus;
+    renderer.setPalette(engine.palette());
+    origin = wxPoint();
+    tiles = engine.grid();
+    ensureVisible(selected);
     announceScore();
     draw();
 }
 
 
+BoardWidget::~BoardWidget() {
+    Settings::get().unlisten(settingsId);
+}
+
+
+// New timings apply at once; the other options wait for a new game
+void BoardWidget::readTimings() {
+    const auto& options = Settings::get().board();
+    delayMs = options.delayMs;
+    hintMs = options.hintMs;
+}
+
+
 void BoardWidget::announceScore() {
     wxCommandEvent event(SCORE_EVENT, GetId());
     event.SetEventObject(this);
-    event.SetInt(score);
     ProcessWindowEvent(event);
 }
 
@@ -67,30 +183,138 @@ void BoardWidget::announceScore() {
 void BoardWidget::announceGameOver(const wxString& outcome) {
     wxCommandEvent event(GAME_OVER_EVENT, GetId());
     event.SetEventObject(this);
-    event.SetInt(score);
     event.SetString(outcome);
     ProcessWindowEvent(event);
 }
 
 
-void BoardWidget::draw(int delayMs, bool force) {
-    if (delayMs)
-        wxMilliSleep(delayMs);
+void BoardWidget::announceHint(const Hint& hint) {
+    wxCommandEvent event(HINT_EVENT, GetId());
+    event.SetEventObject(this);
+    event.SetString(wxString::Format(
+        L"Hint: %d tiles • %.0f%% wins • %s points (%s games)", hint.size,
+        hint.winRate * 100, humanize(std::llround(hint.meanScore)),
+        humanize(hint.playouts)));
+    ProcessWindowEvent(event);
+}
+
+
+void BoardWidget::draw() {
     Refresh();
-    if (force)
-        Update();
 }
 
 
+// Only repaints the given tile
+void BoardWidget::drawTile(const Point point) {
+    if (tiles.contains(point.x, point.y))
+        RefreshRect(tileRect(point.x, point.y), false);
+}
+
+
+// Unless zoomed the board is fitted to the window
 TileSize BoardWidget::tileSize() const {
+    if (zoom)
+        return {static_cast<double>(zoom), static_cast<double>(zoom)};
+    return fitTileSize(GetRect().GetSize(), engine.columns(), engine.rows());
+}
+
+
+BoardView BoardWidget::view() const {
+    const auto size = tileSize();
+    BoardView view;
+    view.size = GetRect().GetSize();
+    view.tileWidth = static_cast<int>(size.width);
+    view.tileHeight = static_cast<int>(size.height);
+    view.origin = origin;
+    view.focus = selected;
+    view.gameOver = gameOver;
+    view.userWon = userWon;
+    return view;
+}
+
+
+// Returns the tile's rectangle in window coordinates
+wxRect BoardWidget::tileRect(int x, int y) const {
+    const auto size = tileSize();
+    const int width = static_cast<int>(size.width);
+    const int height = static_cast<int>(size.height);
+    return wxRect(x * width - origin.x, y * height - origin.y, width,
+                  height);
+}
+
+
+Point BoardWidget::tileAt(const wxPoint& position) const {
+    const auto size = tileSize();
+    return Point((position.x + origin.x) / static_cast<int>(size.width),
+                 (position.y + origin.y) / static_cast<int>(size.height));
+}
+
+
+// Changes the tile size keeping the board pixel under anchor in place
+void BoardWidget::setZoom(int newZoom, const wxPoint& anchor) {
+    if (tiles.empty())
+        return;
+    const auto size = tileSize();
+    const double x = (anchor.x + origin.x) / size.width;
+    const double y = (anchor.y + origin.y) / size.height;
+    zoom = newZoom ? std::max(MIN_TILE_SIZE, std::min(MAX_TILE_SIZE,
+                                                      newZoom))
+                   : 0;
+    const auto newSize = tileSize();
+    origin.x = static_cast<int>(x * newSize.width) - anchor.x;
+    origin.y = static_cast<int>(y * newSize.height) - anchor.y;
+    clampOrigin();
+    draw();
+}
+
+
+void BoardWidget::scrollBy(int dx, int dy) {
+    const auto oldOrigin = origin;
+    origin.x += dx;
+    origin.y += dy;
+    clampOrigin();
+    if (origin != oldOrigin)
+        draw();
+}
+
+
+void BoardWidget::clampOrigin() {
+    if (tiles.empty())
+        return;
+    const auto size = tileSize();
+    const auto rect = GetRect();
+    const int maxX = static_cast<int>(size.width) * engine.columns() -
+                     rect.width;
+    const int maxY = static_cast<int>(size.height) * engine.rows() -
+                     rect.height;
+    origin.x = std::max(0, std::min(maxX, origin.x));
+    origin.y = std::max(0, std::min(maxY, origin.y));
+}
+
+
+void BoardWidget::ensureVisible(const Point point) {
+    if (!point.isValid())
+        return;
+    const auto tile = tileRect(point.x, point.y);
     const auto rect = GetRect();
-    return {rect.width / static_cast<double>(columns),
-            rect.height / static_cast<double>(rows)};
+    int dx = 0;
+    int dy = 0;
+    if (tile.x < 0)
+        dx = tile.x;
+    else if (tile.GetRight() >= rect.width)
+        dx = tile.GetRight() - rect.width + 1;
+    if (tile.y < 0)
+        dy = tile.y;
+    else if (tile.GetBottom() >= rect.height)
+        dy = tile.GetBottom() - rect.height + 1;
+    scrollBy(dx, dy);
 }
 
 
 void BoardWidget::onChar(wxKeyEvent& event) {
-    if (gameOver || drawing) {
+    if (onViewKey(event.GetKeyCode()))
+        return;
+    if (isBusy()) {
         event.Skip();
         return;
     }
@@ -108,9 +332,10 @@ void BoardWidget::onChar(wxKeyEvent& event) {
 
 
 void BoardWidget::onMoveKey(int code) {
+    const auto oldSelected = selected;
     if (!selected.isValid()) {
-        selected.x = columns / 2;
-        selected.y = rows / 2;
+        selected.x = engine.columns() / 2;
+        selected.y = engine.rows() / 2;
     }
     else {
         int x = selected.x;
@@ -123,29 +348,93 @@ void BoardWidget::onMoveKey(int code) {
             --y;
         else if (code == WXK_DOWN)
             ++y;
-        if (0 <= x && x < columns && 0 <= y && y < rows &&
-                tiles[x][y] != wxNullColour) {
+        if (0 <= x && x < engine.columns() && 0 <= y &&
+                y < engine.rows() &&
+                !tiles.isEmpty(x, y)) {
             selected.x = x;
             selected.y = y;
         }
     }
-    draw();
+    drawTile(oldSelected);
+    ensureVisible(selected);
+    drawTile(selected);
+}
+
+
+// Zooming and panning work even when moves can't be made
+bool BoardWidget::onViewKey(int code) {
+    const auto size = tileSize();
+    const int step = static_cast<int>(size.width);
+    const wxPoint middle(GetRect().width / 2, GetRect().height / 2);
+    switch (code) {
+        case '+': case '=': case WXK_NUMPAD_ADD:
+            setZoom(static_cast<int>(size.width * ZOOM_FACTOR) + 1,
+                    middle);
+            return true;
+        case '-': case WXK_NUMPAD_SUBTRACT:
+            setZoom(static_cast<int>(size.width / ZOOM_FACTOR), middle);
+            return true;
+        case '0': case WXK_NUMPAD0:
+            setZoom(0, middle);
+            return true;
+        case WXK_PAGEUP: scrollBy(0, -GetRect().height + step); return true;
+        case WXK_PAGEDOWN: scrollBy(0, GetRect().height - step); return true;
+        case WXK_HOME: scrollBy(-origin.x, -origin.y); return true;
+    }
+    return false;
+}
+
+
+// Ctrl+Wheel zooms; Shift+Wheel scrolls horizontally
+void BoardWidget::onWheel(wxMouseEvent& event) {
+    const int steps = event.GetWheelRotation() /
+                      std::max(1, event.GetWheelDelta());
+    if (!steps)
+        return;
+    if (event.ControlDown()) {
+        const auto size = tileSize();
+        setZoom(static_cast<int>(steps > 0
+                                 ? size.width * ZOOM_FACTOR + 1
+                                 : size.width / ZOOM_FACTOR),
+                event.GetPosition());
+    }
+    else if (event.ShiftDown() ||
+             event.GetWheelAxis() == wxMOUSE_WHEEL_HORIZONTAL)
+        scrollBy(-steps * SCROLL_STEP, 0);
+    else
+        scrollBy(0, -steps * SCROLL_STEP);
+}
+
+
+// Dragging with the middle or right button pans
+void BoardWidget::onPanStart(wxMouseEvent& event) {
+    panStart = event.GetPosition();
+    event.Skip();
+}
+
+
+void BoardWidget::onPan(wxMouseEvent& event) {
+    if (event.Dragging() && (event.MiddleIsDown() || event.RightIsDown())) {
+        const auto position = event.GetPosition();
+        scrollBy(panStart.x - position.x, panStart.y - position.y);
+        panStart = position;
+    }
+    event.Skip();
 }
 
 
 void BoardWidget::onClick(wxMouseEvent& event) {
-    if (gameOver || drawing) {
+    if (isBusy()) {
         event.Skip();
         return;
     }
-    const auto size = tileSize();
-    const int x = static_cast<int>(event.GetX() / round(size.width));
-    const int y = static_cast<int>(event.GetY() / round(size.height));
+    const auto point = tileAt(event.GetPosition());
     if (selected.isValid()) {
+        const auto oldSelected = selected;
         selected.x = selected.y = INVALID_POS;
-        draw();
+        drawTile(oldSelected);
     }
-    deleteTile(Point(x, y));
+    deleteTile(point);
 }
 
 
@@ -157,327 +446,185 @@ wxSize BoardWidget::DoGetBestClientSize() const {
 
 
 void BoardWidget::onPaint(wxPaintEvent&) {
+    TRACE_SCOPE("board/paint");
     if (tiles.empty())
         return;
     drawing = true;
     wxPaintDC dc(this);
-    auto gc = wxGraphicsContext::Create(dc);
-    if (gc) {
-        const auto size = tileSize();
-        const double edge = std::min(size.width, size.height) / 9.0;
-        const double edge2 = edge * 2.0;
-        for (int x = 0; x < columns; ++x)
-            for (int y = 0; y < rows; ++y)
-                drawTile(gc, x, y, size.width, size.height, edge, edge2);
-        if (userWon || gameOver)
-            drawGameOver(gc);
-        delete gc;
-    }
+    const auto boardView = view();
+    renderer.paintMargins(dc, tiles, boardView);
+    // Only the visible tiles that intersect the update region are drawn
+    for (wxRegionIterator region(GetUpdateRegion()); region; ++region)
+        renderer.paintTiles(dc, tiles, boardView, region.GetRect());
+    renderer.paintGameOver(dc, boardView);
     drawing = false;
 }
 
 
-void BoardWidget::drawGameOver(wxGraphicsContext *gc) {
-    const wxString text(userWon ? "You Won!" : "Game Over");
-    wxFont font(36, wxFONTFAMILY_DECORATIVE, wxFONTSTYLE_NORMAL,
-                wxFONTWEIGHT_BOLD);
-    gc->SetFont(font, *wxWHITE);
-    double width;
-    double height;
-    double descent;
-    double leading;
-    gc->GetTextExtent(text, &width, &height, &descent, &leading);
-    const auto rect = GetRect();
-    const auto x = (rect.GetWidth() - width) / 2;
-    const auto y = (rect.GetHeight() / 2) - (height + descent + leading);
-    gc->DrawText(text, x - 2, y - 3);
-    gc->SetFont(font, *wxBLACK);
-    gc->DrawText(text, x, y);
-    wxColour color(userWon ? 0xFF0000BB : 0xFF009900);
-    gc->SetFont(font, color);
-    gc->DrawText(text, x - 1, y - 2);
-}
-
-
-void BoardWidget::drawTile(wxGraphicsContext* gc, int x, int y,
-                           double width, double height, double edge,
-                           double edge2) {
-    const double x1 = x * width;
-    const double y1 = y * height;
-    const auto color = tiles[x][y];
-    if (color == wxNullColour) {
-        gc->SetBrush(wxBrush(BACKGROUND_COLOR));
-        gc->DrawRectangle(x1, y1, width, height);
-    }
-    else {
-        const double x2 = x1 + width;
-        const double y2 = y1 + height;
-        const auto colorPair = getColorPair(color, gameOver);
-        drawSegments(gc, edge, colorPair, x1, y1, x2, y2);
-        auto brush = gc->CreateLinearGradientBrush(
-            x1, y1, x2, y2, colorPair.light, colorPair.dark);
-        gc->SetBrush(brush);
-        gc->DrawRectangle(x1 + edge, y1 + edge, width - edge2,
-                          height - edge2);
-        if (selected.x == x && selected.y == y)
-            drawFocus(gc, x1, y1, edge, width, height);
-    }
+// The whole board as shown, at the current tile size, without the focus
+bool BoardWidget::exportImage(const wxString& filename) {
+    TRACE_SCOPE("board/exportImage");
+    if (tiles.empty())
+        return false;
+    auto boardView = wholeBoardView(tiles,
+                                    static_cast<int>(tileSize().width));
+    boardView.gameOver = gameOver;
+    boardView.userWon = userWon;
+    return savePng(renderer.render(tiles, boardView), filename);
 }
 
 
-void BoardWidget::drawSegments(wxGraphicsContext* gc, double edge,
-                               const ColorPair& colorPair, double x1,
-                               double y1, double x2, double y2) {
-    drawSegment(gc, colorPair.light, {{x1, y1}, {x1 + edge, y1 + edge},
-                {x2 - edge, y1 + edge}, {x2, y1}});
-    drawSegment(gc, colorPair.light, {{x1, y1}, {x1, y2},
-                {x1 + edge, y2 - edge}, {x1 + edge, y1 + edge}});
-    drawSegment(gc, colorPair.dark, {{x2 - edge, y1 + edge}, {x2, y1},
-                {x2, y2}, {x2 - edge, y2 - edge}});
-    drawSegment(gc, colorPair.dark, {{x1, y2}, {x1 + edge, y2 - edge},
-                {x2 - edge, y2 - edge}, {x2, y2}});
+// Returns true if input must be ignored. Since the engine has already
+// finished the move being shown, any animation is skipped to its end.
+bool BoardWidget::isBusy() {
+    sequence.finishAnimation();
+    return sequence.isRunning() || gameOver || drawing;
 }
 
 
-void BoardWidget::drawSegment(wxGraphicsContext* gc, const wxColour& color,
-                              const Coords& coords) {
-    auto path = gc->CreatePath();
-    path.MoveToPoint(coords[0][0], coords[0][1]);
-    for (int i = 1; i < COORDS_LEN; ++i)
-        path.AddLineToPoint(coords[i][0], coords[i][1]);
-    path.CloseSubpath();
-    gc->SetBrush(wxBrush(color));
-    gc->FillPath(path);
+// The engine plays the move at once; the rest is just showing it
+void BoardWidget::deleteTile(const Point point) {
+    TRACE_SCOPE("board/click");
+    if (!engine.isLegal(point))
+        return;
+    showMove(point, engine.apply(point));
 }
 
 
-void BoardWidget::drawFocus(wxGraphicsContext* gc, double x1, double y1,
-                            double edge, double width, double height) {
-    gc->SetBrush(wxBrush());
-    edge *= 4 / 3;
-    const double edge2 = edge * 2;
-    gc->SetPen(wxPen(*wxBLACK, 1, wxPENSTYLE_DOT));
-    gc->DrawRectangle(x1 + edge, y1 + edge, width - edge2, height - edge2);
-    gc->SetPen(wxPen());
+// Shows the move that the engine has just played
+void BoardWidget::showMove(const Point point, const MoveResult& move) {
+    clearHint();
+    hinter.played(point, engine);
+    sequence.start(&tiles, move, delayMs);
 }
 
 
-void BoardWidget::deleteTile(const Point point) {
-    const auto color = tiles[point.x][point.y];
-    if (color == wxNullColour || !isLegal(point, color))
+// Takes back the last move at once, even one that ended the game; a
+// move still being shown is snapped to its end first
+void BoardWidget::undo() {
+    TRACE_SCOPE("board/undo");
+    if (drawing || !engine.canUndo())
         return;
-    dimAdjoining(point, color);
-}
-
-
-bool BoardWidget::isLegal(const Point point, const wxColour& color) {
-    // A legal click is on a colored tile that is adjacent to another
-    // tile of the same color.
-    const auto& x = point.x;
-    const auto& y = point.y;
-    if (x > 0 && tiles[x - 1][y] == color)
-        return true;
-    if (x + 1 < columns && tiles[x + 1][y] == color)
-        return true;
-    if (y > 0 && tiles[x][y - 1] == color)
-        return true;
-    if (y + 1 < rows && tiles[x][y + 1] == color)
-        return true;
-    return false;
+    sequence.stop();
+    clearHint();
+    hinter.cancel();
+    engine.undo();
+    gameOver = false;
+    userWon = false;
+    tiles = engine.grid(); // Undo only refills cells so selected stays
+    announceScore();
+    draw();
 }
 
 
-void BoardWidget::dimAdjoining(const Point point, const wxColour& color) {
-    PointSet adjoining;
-    populateAdjoining(point, color, adjoining);
-    auto colors = colorMap();
-    for (auto it = adjoining.cbegin(); it != adjoining.cend(); ++it) {
-        const int x = (*it).x;
-        const int y = (*it).y;
-        tiles[x][y] = tiles[x][y].ChangeLightness(160);
-    }
-    draw(5);
-    timer.Bind(wxEVT_TIMER,
-               [=](wxTimerEvent&) { deleteAdjoining(adjoining); });
-    timer.StartOnce(delayMs);
+// Replays the last undone move, showing it just like a click
+void BoardWidget::redo() {
+    if (isBusy() || !engine.canRedo())
+        return;
+    const auto move = engine.redo();
+    showMove(engine.history().back(), move);
 }
 
 
-void BoardWidget::populateAdjoining(const Point point,
-                                    const wxColour& color,
-                                    PointSet& adjoining) {
-    const auto& x = point.x;
-    const auto& y = point.y;
-    if (x < 0 || x >= columns || y < 0 || y >= rows)
-        return; // Fallen off an edge
-    if (tiles[x][y] != color)
-        return; // Color doesn't match
-    auto it = adjoining.find(point);
-    if (it != adjoining.end())
-        return; // Already done (C++20 supports .contains())
-    adjoining.insert(point);
-    populateAdjoining(Point(x - 1, y), color, adjoining);
-    populateAdjoining(Point(x + 1, y), color, adjoining);
-    populateAdjoining(Point(x, y - 1), color, adjoining);
-    populateAdjoining(Point(x, y + 1), color, adjoining);
+void BoardWidget::finishMove() {
+    TRACE_SCOPE("board/finishMove");
+    if (selected.isValid() &&
+            tiles.isEmpty(selected.x, selected.y)) {
+        drawTile(selected);
+        selected.x = engine.columns() / 2;
+        selected.y = engine.rows() / 2;
+        drawTile(selected);
+    }
+    announceScore();
+    checkGameOver(sequence.move().state);
 }
 
 
-void BoardWidget::deleteAdjoining(const PointSet adjoining) {
-    for (auto it = adjoining.cbegin(); it != adjoining.cend(); ++it)
-        tiles[(*it).x][(*it).y] = wxNullColour;
-    draw(5);
-    const auto size = adjoining.size();
-    timer.Bind(wxEVT_TIMER, [=](wxTimerEvent&) { closeTilesUp(size); });
-    timer.StartOnce(delayMs);
+void BoardWidget::checkGameOver(GameState state) {
+    userWon = state == GameState::Won;
+    if (state == GameState::Playing)
+        return;
+    gameOver = true;
+    draw();
+    if (!engine.history().empty()) { // A deal lost as dealt wasn't played
+        saveReplay();
+        recordScore();
+    }
+    announceGameOver(userWon ? WON : LOST);
 }
 
 
-void BoardWidget::closeTilesUp(size_t count) {
-    moveTiles();
-    if (selected.isValid() &&
-            tiles[selected.x][selected.y] == wxNullColour) {
-        selected.x = columns / 2;
-        selected.y = rows / 2;
-    }
-    draw();
-    score += static_cast<int>(
-        std::round(std::sqrt(static_cast<double>(columns) * rows)) +
-        std::pow(count, maxColors / 2));
-    announceScore();
-    checkGameOver();
-}
-
-
-void BoardWidget::moveTiles() {
-    PointMap moves;
-    bool moved = true;
-    while (moved) {
-        moved = false;
-        for (int x: rippledRange(columns, randomizer))
-            for (int y: rippledRange(rows, randomizer)) {
-                if (tiles[x][y] != wxNullColour)
-                    if (moveIsPossible(Point(x, y), moves)) {
-                        moved = true;
-                        break;
-                    }
-            }
-    }
+// Every finished game is kept, e.g., so that reported problems can be
+// reproduced exactly with gravitate-replay
+void BoardWidget::saveReplay() {
+    TRACE_SCOPE("board/saveReplay");
+    wxFileName filename(wxStandardPaths::Get().GetUserDataDir(),
+                        wxString::Format("%s-%u.grvr",
+                            wxDateTime::Now().Format("%Y%m%d-%H%M%S"),
+                            engine.seed()));
+    filename.AppendDir(REPLAY_DIR);
+    if (filename.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL))
+        ::saveReplay(filename.GetFullPath().ToStdString(),
+                     makeReplay(engine));
 }
 
 
-bool BoardWidget::moveIsPossible(const Point point, PointMap& moves) {
-    const auto empties = getEmptyNeighbours(point);
-    if (!empties.empty()) {
-        bool move;
-        const auto newPoint = nearestToMiddle(point, empties, &move);
-        auto it = moves.find(newPoint);
-        if (it != moves.end() && it->second == point)
-            return false; // avoid endless loop
-        if (move) {
-            tiles[newPoint.x][newPoint.y] = tiles[point.x][point.y];
-            tiles[point.x][point.y] = wxNullColour;
-            draw(std::max(1, static_cast<int>(std::round(delayMs / 7))),
-                 true);
-            moves.insert({point, newPoint});
-            return true;
-        }
-    }
-    return false;
+// Adds the game to the score database for the statistics and
+// leaderboards; a resumed game's time only counts since it was resumed
+void BoardWidget::recordScore() {
+    TRACE_SCOPE("board/recordScore");
+    if (recorded)
+        return;
+    recorded = true;
+    GameRecord record;
+    record.columns = static_cast<std::uint32_t>(engine.columns());
+    record.rows = static_cast<std::uint32_t>(engine.rows());
+    record.maxColors = static_cast<std::uint32_t>(engine.maxColors());
+    record.seed = engine.seed();
+    record.score = engine.score();
+    record.moves = static_cast<std::uint32_t>(engine.history().size());
+    record.durationMs = static_cast<std::uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count());
+    record.finished = wxDateTime::Now().GetTicks();
+    record.won = userWon;
+    scoreDb.add(record);
 }
 
 
-PointSet BoardWidget::getEmptyNeighbours(const Point point) {
-    PointSet neighbours;
-    const auto& x = point.x;
-    const auto& y = point.y;
-    const Point points[]{Point(x - 1, y), Point(x + 1, y),
-                         Point(x, y - 1), Point(x, y + 1)};
-    for (auto newPoint: points) {
-        if (0 <= newPoint.x && newPoint.x < columns && 0 <= newPoint.y &&
-                newPoint.y < rows &&
-                tiles[newPoint.x][newPoint.y] == wxNullColour)
-            neighbours.insert(newPoint);
-    }
-    return neighbours;
-}
-
-
-Point BoardWidget::nearestToMiddle(const Point point,
-                                   const PointSet& empties, bool* move) {
-    const auto color = tiles[point.x][point.y];
-    const int midX = columns / 2;
-    const int midY = rows / 2;
-    const double oldRadius = std::hypot(midX - point.x, midY - point.y);
-    double shortestRadius = NAN;
-    Point radiusPoint;
-    for (const auto& newPoint: empties) {
-        if (isSquare(newPoint)) {
-            double newRadius = std::hypot(midX - newPoint.x,
-                                          midY - newPoint.y);
-            if (isLegal(newPoint, color))
-                newRadius -= 0.1; // Make same colors slightly attract
-            if (!radiusPoint.isValid() || shortestRadius > newRadius) {
-                shortestRadius = newRadius;
-                radiusPoint = newPoint;
-            }
-        }
-    }
-    if (!std::isnan(shortestRadius) && oldRadius > shortestRadius) {
-        *move = true;
-        return radiusPoint;
-    }
-    *move = false;
-    return point;
-}
-
-
-bool BoardWidget::isSquare(const Point& point) {
-    const auto x = point.x;
-    const auto y = point.y;
-    if (x > 0 && tiles[x - 1][y] != wxNullColour)
-        return true;
-    if (x + 1 < columns && tiles[x + 1][y] != wxNullColour)
-        return true;
-    if (y > 0 && tiles[x][y - 1] != wxNullColour)
-        return true;
-    if (y + 1 < rows && tiles[x][y + 1] != wxNullColour)
-        return true;
-    return false;
+// Analysis runs on every core in the background until hintMs is up, when
+// the best group found is highlighted; making a move cancels it
+void BoardWidget::hint() {
+    if (isBusy())
+        return;
+    clearHint();
+    hinter.start(engine, hintMs);
+    hintTimer.StartOnce(hintMs);
 }
 
 
-void BoardWidget::checkGameOver() {
-    auto canMove = checkTiles();
-    if (userWon)
-        announceGameOver(WON);
-    else if (!canMove)
-        announceGameOver(LOST);
+void BoardWidget::showHint() {
+    TRACE_SCOPE("board/showHint");
+    if (sequence.isRunning() || gameOver)
+        return;
+    const auto best = hinter.best();
+    if (!best.isValid())
+        return;
+    hinted = engine.adjoining(best.point);
+    for (const auto& point: hinted) {
+        tiles.at(point.x, point.y) |= HINTED;
+        drawTile(point);
+    }
+    ensureVisible(best.point);
+    announceHint(best);
 }
 
 
-bool BoardWidget::checkTiles() {
-    std::unordered_map<wxUint32, int> countForColor;
-    userWon = true;
-    bool canMove = false;
-    for (int x = 0; x < columns; ++x)
-        for (int y = 0; y < rows; ++y) {
-            const auto color = tiles[x][y];
-            if (color != wxNullColour) {
-                ++countForColor[color.GetRGBA()];
-                userWon = false;
-                if (isLegal(Point(x, y), color))
-                    canMove = true;
-            }
-        }
-    for (auto it = countForColor.cbegin(); it != countForColor.cend(); ++it)
-        if (it->second == 1) {
-            canMove = false;
-            break;
-        }
-    if (userWon || !canMove) {
-        gameOver = true;
-        draw();
+void BoardWidget::clearHint() {
+    hintTimer.Stop();
+    for (const auto& point: hinted) {
+        tiles.at(point.x, point.y) &= ~HINTED;
+        drawTile(point);
     }
-    return canMove;
+    hinted.clear();
 }
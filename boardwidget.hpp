@@ -3,60 +3,83 @@
 // License: GPLv3
 
 #include "constants.hpp"
+#include "boardrenderer.hpp"
 #include "boardutil.hpp"
+#include "dealer.hpp"
+#include "hinter.hpp"
+#include "movesequence.hpp"
+#include "scoredb.hpp"
 
 #include <wx/wxprec.h>
 #ifndef WX_PRECOMP
     #include <wx/wx.h>
 #endif
-#include <wx/graphics.h>
+
+#include <chrono>
+#include <optional>
 
 
 wxDECLARE_EVENT(SCORE_EVENT, wxCommandEvent);
 wxDECLARE_EVENT(GAME_OVER_EVENT, wxCommandEvent);
+wxDECLARE_EVENT(HINT_EVENT, wxCommandEvent);
 
 
 class BoardWidget : public wxWindow {
 public:
     explicit BoardWidget(wxWindow* parent);
+    ~BoardWidget();
 
-    void newGame();
+    void newGame(std::optional<unsigned> seed={}); // Random if no seed
+    bool resumeGame();
+    void saveGame();
+    void hint();
+    void undo();
+    void redo();
+    bool exportImage(const wxString& filename);
+    Score score() const { return engine.score(); }
+    unsigned seed() const { return engine.seed(); }
+    bool isProvenSolvable() const { return provenSolvable; }
+    bool isGameOver() const { return gameOver; }
+    const ScoreDb& scores() const { return scoreDb; }
 
 private:
+    wxString snapshotFilename() const;
+    wxString dealsFilename() const;
+    void stopGame();
+    void startGame(const Point& focus);
+    void readTimings();
+    void fillDeals();
     void announceScore();
     void announceGameOver(const wxString&);
-    void draw(int delayMs=0, bool force=false);
+    void announceHint(const Hint& hint);
+    void draw();
+    void drawTile(const Point point);
     TileSize tileSize() const;
-    void drawTile(wxGraphicsContext* gc, int x, int y, double width,
-                  double height, double edge, double edge2);
-    void drawSegments(wxGraphicsContext* gc, double edge,
-                      const ColorPair& colorPair, double x1, double y1,
-                      double x2, double y2);
-    void drawSegment(wxGraphicsContext* gc, const wxColour& color,
-                     const Coords& coords);
-    void drawFocus(wxGraphicsContext* gc, double x1, double y1, double edge,
-                   double width, double height);
-    void drawGameOver(wxGraphicsContext *gc);
+    BoardView view() const;
+    wxRect tileRect(int x, int y) const;
+    Point tileAt(const wxPoint& position) const;
+    void setZoom(int newZoom, const wxPoint& anchor);
+    void scrollBy(int dx, int dy);
+    void clampOrigin();
+    void ensureVisible(const Point point);
     void deleteTile(const Point point);
-    bool isLegal(const Point point, const wxColour& color);
-    void dimAdjoining(const Point point, const wxColour& color);
-    void populateAdjoining(const Point point, const wxColour& color,
-                           PointSet& adjoining);
-    void deleteAdjoining(const PointSet adjoining);
-    void closeTilesUp(size_t count);
-    void moveTiles();
-    bool moveIsPossible(const Point point, PointMap& moves);
-    PointSet getEmptyNeighbours(const Point point);
-    Point nearestToMiddle(const Point point, const PointSet& empties,
-                          bool* move);
-    bool isSquare(const Point& point);
-    void checkGameOver();
-    bool checkTiles();
+    void showMove(const Point point, const MoveResult& move);
+    void finishMove();
+    void checkGameOver(GameState state);
+    void saveReplay();
+    void recordScore();
+    void showHint();
+    void clearHint();
+    bool isBusy();
 
     void onPaint(wxPaintEvent&);
     void onChar(wxKeyEvent&);
     void onClick(wxMouseEvent&);
     void onMoveKey(int code);
+    bool onViewKey(int code);
+    void onWheel(wxMouseEvent&);
+    void onPanStart(wxMouseEvent&);
+    void onPan(wxMouseEvent&);
 
 #if wxVERSION_NUMBER >= 3100
     wxSize DoGetBestClientSize() const wxOVERRIDE;
@@ -64,16 +87,26 @@ private:
     wxSize DoGetBestClientSize() const;
 #endif
 
-    int score;
     bool gameOver;
     bool userWon;
+    bool recorded; // Only a deal's first finish counts, despite undo
+    bool provenSolvable; // The deal came from the dealer's pool
     bool drawing;
-    int columns;
-    int rows;
-    int maxColors;
     int delayMs;
+    int hintMs;
     Point selected;
-    TileGrid tiles;
-    wxTimer timer;
-    Randomizer randomizer;
+    int zoom; // Tile size in pixels, or 0 to fit the board to the window
+    wxPoint origin; // The board pixel shown at the window's top-left
+    wxPoint panStart;
+    Engine engine;
+    Grid tiles; // What is shown; the engine is always ahead of it
+    MoveSequence sequence; // Shows the engine's moves on tiles
+    BoardRenderer renderer;
+    Hinter hinter;
+    wxTimer hintTimer;
+    Points hinted; // The tiles of the group shown as the hint
+    int settingsId;
+    ScoreDb scoreDb;
+    Dealer dealer;
+    std::chrono::steady_clock::time_point started;
 };
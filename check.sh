@@ -0,0 +1,14 @@
+#!/bin/bash
+# Regression runs for bugs that were fixed: builds the tools and stops at
+# the first run that fails or hangs. gravitate-bench needs a display, so
+# use xvfb-run on a headless host.
+set -e
+scons -s gravitate-sim gravitate-bench
+# Seed 2546 deals a 5 x 5 board with no legal move
+timeout 10 ./gravitate-sim --games 1 --seed 2546 --sizes 5x5 --colors 6 \
+    > /dev/null
+# Many of these deals are lost as dealt
+timeout 60 ./gravitate-sim --games 5000 --sizes 5x5 --colors 6 > /dev/null
+# Showing a move must always take the same two timer events
+./gravitate-bench move/sequence > /dev/null
+echo OK
@@ -0,0 +1,343 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include "components.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+
+
+// Labels every group in two row-major passes, which read the board in
+// order rather than jumping about as flood fills do, so even a huge board
+// builds quickly. The first pass joins each tile to its same-colored left
+// and upper neighbours in a union-find forest kept in labels, where every
+// tile's parent precedes it and each root is its group's first tile. The
+// second pass replaces the parents with labels in the same order.
+void Components::build(const Grid& tiles) {
+    forgetUndos();
+    relabel(tiles);
+}
+
+
+void Components::relabel(const Grid& tiles) {
+    TRACE_SCOPE("components/relabel");
+    columns = tiles.columns();
+    rows = tiles.rows();
+    tileCount_ = 0;
+    legalMoveCount_ = 0;
+    largest_ = 0;
+    std::fill(std::begin(colorCounts), std::end(colorCounts), 0);
+    labels.assign(tiles.size(), NO_LABEL);
+    components.clear();
+    freeLabels.clear();
+    sizeCounts.assign(tiles.size() + 1, 0);
+    marks.assign(tiles.size(), 0);
+    epoch = 0;
+    for (int y = 0, i = 0; y < rows; ++y)
+        for (int x = 0; x < columns; ++x, ++i) {
+            const int color = tiles[i] & COLOR_MASK;
+            if (color == NO_COLOR)
+                continue;
+            labels[i] = i;
+            if (x > 0 && (tiles[i - 1] & COLOR_MASK) == color)
+                unite(i - 1, i);
+            if (y > 0 && (tiles[i - columns] & COLOR_MASK) == color)
+                unite(i - columns, i);
+        }
+    for (int i = 0; i < tiles.size(); ++i) {
+        const int parent = labels[i];
+        if (parent == NO_LABEL)
+            continue;
+        if (parent == i) {
+            labels[i] = static_cast<int>(components.size());
+            components.push_back({0, tiles[i] & COLOR_MASK});
+        }
+        else
+            labels[i] = labels[parent]; // Already relabelled
+        ++components[labels[i]].size;
+    }
+    for (const auto& component: components)
+        count(component, 1);
+}
+
+
+// Only used by build(): joins the trees of cells i and j, keeping the
+// smaller root (the earlier tile) as the root and halving paths as it goes
+void Components::unite(int i, int j) {
+    while (labels[i] != i)
+        i = labels[i] = labels[labels[i]];
+    while (labels[j] != j)
+        j = labels[j] = labels[labels[j]];
+    if (i < j)
+        labels[j] = i;
+    else if (j < i)
+        labels[i] = j;
+}
+
+
+// Relabels every group that contains or adjoins a changed cell. The old
+// labels still describe the board as it was before the changes, so each
+// old group's cells can be found by following its label; the new groups
+// can only be made of these cells and the changed cells themselves. If
+// undoable is true, every label and group that is replaced is logged so
+// that undo() can put them back without relabelling anything.
+void Components::update(const Grid& tiles, const Points& changed,
+                        bool undoable) {
+    TRACE_SCOPE("components/update");
+    if (undoable)
+        steps.push_back({static_cast<int>(components.size()),
+                         static_cast<int>(freeLabels.size()), false, 0, 0,
+                         0, 0});
+    // On small boards most tiles often move; then it is cheaper to
+    // relabel everything (saving everything first, to undo) than to
+    // collect the old groups first
+    if (changed.size() * 2 > labels.size()) {
+        if (undoable) {
+            steps.back().full = true;
+            savedLabels.insert(savedLabels.end(), labels.cbegin(),
+                               labels.cend());
+            savedComponents.insert(savedComponents.end(),
+                                   components.cbegin(), components.cend());
+            savedLabels.insert(savedLabels.end(), freeLabels.cbegin(),
+                               freeLabels.cend());
+        }
+        relabel(tiles);
+        return;
+    }
+    logging = undoable;
+    if (++epoch == 0) { // Wrapped around
+        std::fill(marks.begin(), marks.end(), 0);
+        epoch = 1;
+    }
+    region.clear();
+    for (const auto& point: changed) {
+        const int i = index(point.x, point.y);
+        if (labels[i] != NO_LABEL)
+            collect(i, labels[i]);
+        else if (marks[i] != epoch) {
+            marks[i] = epoch;
+            region.push_back(i);
+        }
+        const int x = point.x;
+        const int y = point.y;
+        if (x > 0 && labels[i - 1] != NO_LABEL)
+            collect(i - 1, labels[i - 1]);
+        if (x + 1 < columns && labels[i + 1] != NO_LABEL)
+            collect(i + 1, labels[i + 1]);
+        if (y > 0 && labels[i - columns] != NO_LABEL)
+            collect(i - columns, labels[i - columns]);
+        if (y + 1 < rows && labels[i + columns] != NO_LABEL)
+            collect(i + columns, labels[i + columns]);
+    }
+    if (logging) {
+        for (const int i: region)
+            oldLabels.push_back({i, labels[i]});
+        steps.back().oldLabels = static_cast<int>(region.size());
+    }
+    for (const int i: region)
+        labels[i] = NO_LABEL;
+    for (const int i: region)
+        if ((tiles[i] & COLOR_MASK) != NO_COLOR && labels[i] == NO_LABEL)
+            addComponent(tiles, i);
+    logging = false;
+}
+
+
+// Reverts the last undoable update() in the reverse order it was made:
+// its new groups are dropped, the old labels and groups restored, and
+// any free labels that it reused are made free again
+void Components::undo() {
+    TRACE_SCOPE("components/undo");
+    const auto step = steps.back();
+    steps.pop_back();
+    if (step.full) {
+        restore(step);
+        return;
+    }
+    for (int k = 0; k < step.newLabels; ++k) {
+        auto& component = components[newLabels.back()];
+        count(component, -1);
+        component.size = 0;
+        newLabels.pop_back();
+    }
+    for (int k = 0; k < step.oldLabels; ++k) {
+        labels[oldLabels.back().first] = oldLabels.back().second;
+        oldLabels.pop_back();
+    }
+    for (int k = 0; k < step.oldComponents; ++k) {
+        const auto& old = oldComponents.back();
+        components[old.first] = old.second;
+        count(old.second, 1);
+        oldComponents.pop_back();
+    }
+    freeLabels.resize(step.freeLabels - step.takenLabels);
+    for (int k = 0; k < step.takenLabels; ++k) {
+        freeLabels.push_back(takenLabels.back());
+        takenLabels.pop_back();
+    }
+    components.resize(step.components);
+}
+
+
+void Components::forgetUndos() {
+    steps.clear();
+    oldLabels.clear();
+    oldComponents.clear();
+    newLabels.clear();
+    takenLabels.clear();
+    savedLabels.clear();
+    savedComponents.clear();
+}
+
+
+// Undoes a relabelling by putting back everything that was saved before
+// it (the free labels were saved after the labels) and recounting
+void Components::restore(const Step& step) {
+    const auto freed = savedLabels.cend() - step.freeLabels;
+    freeLabels.assign(freed, savedLabels.cend());
+    const auto first = freed - static_cast<int>(labels.size());
+    std::copy(first, freed, labels.begin());
+    savedLabels.erase(first, savedLabels.cend());
+    const auto saved = savedComponents.cend() - step.components;
+    components.assign(saved, savedComponents.cend());
+    savedComponents.erase(saved, savedComponents.cend());
+    tileCount_ = 0;
+    legalMoveCount_ = 0;
+    largest_ = 0;
+    std::fill(std::begin(colorCounts), std::end(colorCounts), 0);
+    std::fill(sizeCounts.begin(), sizeCounts.end(), 0);
+    for (const auto& component: components)
+        count(component, 1); // Free labels' groups have no tiles
+}
+
+
+int Components::largest() const {
+    while (largest_ > 0 && sizeCounts[largest_] == 0)
+        --largest_;
+    return largest_;
+}
+
+
+bool Components::hasSingletonColor() const {
+    for (int color = 1; color <= MAX_COLOR_INDEX; ++color)
+        if (colorCounts[color] == 1)
+            return true;
+    return false;
+}
+
+
+// Appends one tile of each legal group: the group's first tile in
+// row-major order, which is also the first of Engine::adjoining()'s points
+void Components::legalMoves(Points& moves) const {
+    if (++seenEpoch == 0) { // Wrapped around
+        std::fill(seen.begin(), seen.end(), 0);
+        seenEpoch = 1;
+    }
+    if (seen.size() < components.size())
+        seen.resize(components.size(), 0);
+    for (int i = 0; i < static_cast<int>(labels.size()); ++i) {
+        const int label = labels[i];
+        if (label != NO_LABEL && seen[label] != seenEpoch) {
+            seen[label] = seenEpoch;
+            if (components[label].size > 1)
+                moves.push_back(Point(i % columns, i / columns));
+        }
+    }
+}
+
+
+// Adds the cells of the old group with the given label to the region
+// being relabelled, and forgets the group
+void Components::collect(int start, int label) {
+    if (marks[start] == epoch)
+        return;
+    marks[start] = epoch;
+    stack.push_back(start);
+    while (!stack.empty()) {
+        const int i = stack.back();
+        stack.pop_back();
+        region.push_back(i);
+        const int x = i % columns;
+        const int y = i / columns;
+        const int neighbours[]{x > 0 ? i - 1 : -1,
+                               x + 1 < columns ? i + 1 : -1,
+                               y > 0 ? i - columns : -1,
+                               y + 1 < rows ? i + columns : -1};
+        for (const int j: neighbours)
+            if (j != -1 && marks[j] != epoch && labels[j] == label) {
+                marks[j] = epoch;
+                stack.push_back(j);
+            }
+    }
+    release(label);
+}
+
+
+void Components::release(int label) {
+    if (logging) {
+        oldComponents.push_back({label, components[label]});
+        ++steps.back().oldComponents;
+    }
+    count(components[label], -1);
+    components[label].size = 0;
+    freeLabels.push_back(label);
+}
+
+
+// Adds a group to (sign 1) or removes it from (sign -1) the totals
+void Components::count(const Component& component, int sign) {
+    sizeCounts[component.size] += sign;
+    if (component.size > 1)
+        legalMoveCount_ += sign;
+    if (sign > 0)
+        largest_ = std::max(largest_, component.size);
+    tileCount_ += sign * component.size;
+    colorCounts[component.color] += sign * component.size;
+}
+
+
+// Labels the unlabelled group that includes the start cell
+void Components::addComponent(const Grid& tiles, int start) {
+    int label;
+    if (freeLabels.empty()) {
+        label = static_cast<int>(components.size());
+        components.push_back(Component());
+    }
+    else {
+        label = freeLabels.back();
+        freeLabels.pop_back();
+        // Labels below the step's freeLabels were free before this update
+        if (logging && static_cast<int>(freeLabels.size()) <
+                steps.back().freeLabels) {
+            takenLabels.push_back(label);
+            ++steps.back().takenLabels;
+        }
+    }
+    if (logging) {
+        newLabels.push_back(label);
+        ++steps.back().newLabels;
+    }
+    const int color = tiles[start] & COLOR_MASK;
+    int size = 0;
+    labels[start] = label;
+    stack.push_back(start);
+    while (!stack.empty()) {
+        const int i = stack.back();
+        stack.pop_back();
+        ++size;
+        const int x = i % columns;
+        const int y = i / columns;
+        const int neighbours[]{x > 0 ? i - 1 : -1,
+                               x + 1 < columns ? i + 1 : -1,
+                               y > 0 ? i - columns : -1,
+                               y + 1 < rows ? i + columns : -1};
+        for (const int j: neighbours)
+            if (j != -1 && labels[j] == NO_LABEL &&
+                    (tiles[j] & COLOR_MASK) == color) {
+                labels[j] = label;
+                stack.push_back(j);
+            }
+    }
+    components[label] = {size, color};
+    count(components[label], 1);
+}
@@ -0,0 +1,94 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    A labelling of the board's same-color groups with each group's size
+    and color. After a move only the groups that touch a changed cell are
+    relabelled, so an update costs time proportional to the changed tiles
+    and the groups around them rather than to the board size. An update
+    can also log what it replaces so that it can be undone just as
+    cheaply.
+*/
+
+#include "grid.hpp"
+
+#include <utility>
+#include <vector>
+
+
+const int NO_LABEL = -1;
+
+
+class Components {
+public:
+    void build(const Grid& tiles);
+    void update(const Grid& tiles, const Points& changed,
+                bool undoable=false);
+    void undo();
+    void forgetUndos();
+
+    int label(int x, int y) const { return labels[index(x, y)]; }
+    int size(int x, int y) const {
+        const int label = labels[index(x, y)];
+        return label == NO_LABEL ? 0 : components[label].size;
+    }
+    bool isLegal(int x, int y) const { return size(x, y) > 1; }
+
+    int tileCount() const { return tileCount_; }
+    int colorCount(int color) const { return colorCounts[color]; }
+    int legalMoveCount() const { return legalMoveCount_; }
+    int largest() const;
+    bool hasSingletonColor() const;
+    void legalMoves(Points& moves) const;
+
+private:
+    struct Component {
+        int size;
+        int color;
+    };
+
+    struct Step { // What one undoable update() logged
+        int components; // components.size() before
+        int freeLabels; // freeLabels.size() before
+        bool full; // Everything was saved and relabelled
+        int oldLabels;
+        int oldComponents;
+        int newLabels;
+        int takenLabels;
+    };
+
+    int index(int x, int y) const { return y * columns + x; }
+    void unite(int i, int j);
+    void relabel(const Grid& tiles);
+    void restore(const Step& step);
+    void release(int label);
+    void count(const Component& component, int sign);
+    void addComponent(const Grid& tiles, int start);
+    void collect(int start, int label);
+
+    int columns;
+    int rows;
+    int tileCount_;
+    int legalMoveCount_;
+    mutable int largest_;
+    int colorCounts[MAX_COLOR_INDEX + 1];
+    std::vector<int> labels; // One per cell
+    std::vector<Component> components; // Indexed by label
+    std::vector<int> freeLabels;
+    std::vector<int> sizeCounts; // How many groups there are of each size
+    std::vector<int> stack; // Scratch space reused by every flood fill
+    std::vector<int> region; // Scratch space for the cells being relabelled
+    std::vector<unsigned> marks; // Cells visited in the current update
+    unsigned epoch;
+    mutable std::vector<unsigned> seen; // Labels listed by legalMoves()
+    mutable unsigned seenEpoch = 0;
+    bool logging = false; // Only true during an undoable update()
+    std::vector<Step> steps;
+    std::vector<std::pair<int, int>> oldLabels; // Cell and its old label
+    std::vector<std::pair<int, Component>> oldComponents; // By label
+    std::vector<int> newLabels;
+    std::vector<int> takenLabels; // Free labels reused, in the order taken
+    std::vector<int> savedLabels; // For full steps: labels, free labels
+    std::vector<Component> savedComponents; // For full steps
+};
@@ -14,6 +14,8 @@ const wxString COLUMNS("Board/Columns");
 const wxString ROWS("Board/Rows");
 const wxString MAX_COLORS("Board/MaxColors");
 const wxString DELAY_MS("Board/DelayMs");
+const wxString HINT_MS("Board/HintMs");
+const wxString SOLVABLE_ONLY("Board/SolvableOnly");
 const wxString HIGH_SCORE("HighScore");
 const wxString WINDOW_HEIGHT("Window/Height");
 const wxString WINDOW_WIDTH("Window/Width");
@@ -24,9 +26,18 @@ const int COLUMNS_DEFAULT = 9;
 const int ROWS_DEFAULT = 9;
 const int MAX_COLORS_DEFAULT = 4;
 const int DELAY_MS_DEFAULT = 200;
+const int HINT_MS_DEFAULT = 200; // How long the hinter may think
+const int DEALER_THREADS = 2; // Finding solvable deals in the background
 const int HIGH_SCORE_DEFAULT = 0;
+const int BOARD_SIZE_MIN = 5;
+
+const int MIN_TILE_SIZE = 4; // Pixels; larger boards must be panned
+const int MAX_TILE_SIZE = 256;
+const double ZOOM_FACTOR = 1.25;
+const int SCROLL_STEP = 40;
 
 const int TIMEOUT = 5000; // 5 sec
+const int FRAME_MS = 16; // About 60 frames per second
 const int PAD = 5;
 const int COORDS_LEN = 4;
 
@@ -35,6 +46,13 @@ const auto FRAME_STYLE = wxDEFAULT_FRAME_STYLE | wxDEFAULT_DIALOG_STYLE |
 
 const wxString ICON_ID("ICON");
 const wxString OPTIONS_ID("OPTIONS");
+const wxString REPLAY_DIR("replays"); // In the user data directory
+const wxString SNAPSHOT_FILE("game.grvs"); // In the user data directory
+const wxString SCORE_LOG_FILE("scores.grvl"); // In the user data directory
+const wxString SCORE_INDEX_FILE("scores.grvi"); // In the user data dir.
+const wxString DEALS_FILE("deals.grvd"); // In the user data directory
+const int HINT_TOOL_ID = wxID_HIGHEST + 1;
+const int SCORES_TOOL_ID = wxID_HIGHEST + 2;
 
 const wxString LOST("LOST");
 const wxString WON("WON");
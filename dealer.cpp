@@ -0,0 +1,261 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include "dealer.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char MAGIC[] = "GRVD";
+const std::uint32_t BYTE_ORDER_CHECK = 0x01020304; // Differs if swapped
+const std::uint32_t DEALS_LIMIT = 1 << 20; // Sanity check for bad files
+const int TABLE_BITS = 16; // Each worker's solver; small boards need little
+
+struct Header {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint32_t count;
+};
+
+struct Deal {
+    std::uint32_t columns;
+    std::uint32_t rows;
+    std::uint32_t maxColors;
+    std::uint32_t seed;
+};
+
+
+bool isValid(const Configuration& configuration) {
+    return configuration.columns > 0 &&
+           configuration.columns <= DEAL_CELLS_MAX &&
+           configuration.rows > 0 && configuration.rows <= DEAL_CELLS_MAX &&
+           configuration.maxColors > 1 &&
+           configuration.maxColors <= PALETTE_SIZE &&
+           Dealer::canProve(configuration);
+}
+
+} // namespace
+
+
+// A deal with no legal move or with a color that has a single tile can
+// never be won, and that is far quicker to see than to search for
+DealVerdict checkDeal(const Engine& engine, Solver& solver,
+                      long long maxNodes) {
+    if (engine.state() != GameState::Playing)
+        return DealVerdict::Dead;
+    const auto solution = solver.prove(engine, maxNodes);
+    if (solution.winnable)
+        return DealVerdict::Solvable;
+    return solution.proven ? DealVerdict::Unwinnable
+                           : DealVerdict::Undecided;
+}
+
+
+struct Dealer::State {
+    struct Pool {
+        std::deque<unsigned> seeds;
+        int wanted = 0;
+        int tasks = 0; // Tasks filling the pool
+        DealStats stats;
+    };
+
+    long long maxNodes;
+    std::atomic<bool> cancelled{false};
+    mutable std::mutex mutex; // Guards pools
+    std::map<Configuration, Pool> pools;
+};
+
+
+Dealer::Dealer(int threads, long long maxNodes)
+        : state(std::make_shared<State>()), pool(threads) {
+    state->maxNodes = maxNodes;
+}
+
+
+// Tasks still queued stop at once; one that is checking a deal finishes
+Dealer::~Dealer() {
+    state->cancelled = true;
+}
+
+
+// Starts a task on each idle worker, as many as the pool needs, unless
+// the configuration is too big to prove deals for
+void Dealer::fill(const Configuration& configuration, int count) {
+    if (!canProve(configuration))
+        return;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    auto& deals = state->pools[configuration];
+    deals.wanted = std::max(deals.wanted, count);
+    const int needed = std::min(
+        deals.wanted - static_cast<int>(deals.seeds.size()), pool.size());
+    for (; deals.tasks < needed; ++deals.tasks)
+        submit(state, configuration);
+}
+
+
+std::optional<unsigned> Dealer::take(const Configuration& configuration) {
+    std::optional<unsigned> seed;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        auto& seeds = state->pools[configuration].seeds;
+        if (!seeds.empty()) {
+            seed = seeds.front();
+            seeds.pop_front();
+        }
+    }
+    fill(configuration);
+    return seed;
+}
+
+
+int Dealer::ready(const Configuration& configuration) const {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    const auto i = state->pools.find(configuration);
+    return i == state->pools.cend()
+        ? 0 : static_cast<int>(i->second.seeds.size());
+}
+
+
+DealStats Dealer::stats(const Configuration& configuration) const {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    const auto i = state->pools.find(configuration);
+    return i == state->pools.cend() ? DealStats() : i->second.stats;
+}
+
+
+void Dealer::wait() {
+    pool.wait();
+}
+
+
+// Each task checks one candidate and then resubmits itself until its
+// pool is full; each worker keeps its own engine and solver
+void Dealer::submit(std::shared_ptr<State> state,
+                    Configuration configuration) {
+    pool.submit([this, state, configuration]() {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            auto& deals = state->pools[configuration];
+            if (state->cancelled ||
+                    static_cast<int>(deals.seeds.size()) >= deals.wanted) {
+                --deals.tasks;
+                return;
+            }
+        }
+        TRACE_SCOPE("dealer/check");
+        thread_local Randomizer random(std::random_device{}());
+        thread_local Engine engine(0);
+        thread_local Solver solver(TABLE_BITS);
+        const auto start = Clock::now();
+        const auto seed = static_cast<unsigned>(random());
+        engine.newGame(configuration.columns, configuration.rows,
+                       configuration.maxColors, seed);
+        const auto verdict = checkDeal(engine, solver, state->maxNodes);
+        const double seconds = std::chrono::duration<double>(
+            Clock::now() - start).count();
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            auto& deals = state->pools[configuration];
+            auto& stats = deals.stats;
+            ++stats.candidates;
+            stats.seconds += seconds;
+            switch (verdict) {
+                case DealVerdict::Solvable:
+                    ++stats.accepted;
+                    if (static_cast<int>(deals.seeds.size()) <
+                            deals.wanted) {
+                        deals.seeds.push_back(seed);
+                        ++stats.pooled;
+                    }
+                    break;
+                case DealVerdict::Dead: ++stats.dead; break;
+                case DealVerdict::Unwinnable: ++stats.unwinnable; break;
+                case DealVerdict::Undecided: ++stats.undecided; break;
+            }
+        }
+        submit(state, configuration);
+    });
+}
+
+
+// The seeds are added to any already in the pools; returns false if
+// there's no valid file
+bool Dealer::load(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    Header header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, MAGIC, sizeof(header.magic)) ||
+            header.version != DEALS_VERSION ||
+            header.byteOrder != BYTE_ORDER_CHECK ||
+            header.count > DEALS_LIMIT)
+        return false;
+    std::vector<Deal> deals(header.count);
+    if (!file.read(reinterpret_cast<char*>(deals.data()),
+                   static_cast<std::streamsize>(deals.size() *
+                                                sizeof(Deal))))
+        return false;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    for (const auto& deal: deals) {
+        const Configuration configuration{static_cast<int>(deal.columns),
+                                          static_cast<int>(deal.rows),
+                                          static_cast<int>(deal.maxColors)};
+        if (isValid(configuration))
+            state->pools[configuration].seeds.push_back(deal.seed);
+    }
+    return true;
+}
+
+
+// Like snapshots, written to a temporary file that replaces the old one
+// once it is complete
+bool Dealer::save(const std::string& filename) const {
+    std::vector<Deal> deals;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        for (const auto& [configuration, pool]: state->pools)
+            for (const auto seed: pool.seeds)
+                deals.push_back({
+                    static_cast<std::uint32_t>(configuration.columns),
+                    static_cast<std::uint32_t>(configuration.rows),
+                    static_cast<std::uint32_t>(configuration.maxColors),
+                    seed});
+    }
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.version = DEALS_VERSION;
+    header.byteOrder = BYTE_ORDER_CHECK;
+    header.count = static_cast<std::uint32_t>(deals.size());
+    const auto temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(deals.data()),
+                   static_cast<std::streamsize>(deals.size() *
+                                                sizeof(Deal)));
+        if (!file.flush()) {
+            file.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), filename.c_str()) == 0)
+        return true;
+    std::remove(filename.c_str()); // Windows won't rename over a file
+    return std::rename(temporary.c_str(), filename.c_str()) == 0;
+}
@@ -0,0 +1,84 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    Deals that are proven winnable, with no wx dependency. Since a deal is
+    fully determined by its configuration and seed, a solvable deal is
+    kept as just its seed. The Dealer keeps a pool of seeds for each
+    configuration, topped up in the background: candidate seeds are dealt
+    and each is kept only if the solver proves within maxNodes that it can
+    be won. Deals that are lost as dealt (e.g., a color with a single tile)
+    are rejected without searching, and those the solver can't decide in
+    time are rejected too. The pools can be saved and loaded, so they
+    survive between runs and taking a deal never waits for the solver.
+*/
+
+#include "engine.hpp"
+#include "solver.hpp"
+#include "threadpool.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
+
+
+const int DEAL_POOL_SIZE = 16; // Deals kept ready per configuration
+const long long DEAL_MAX_NODES = 200000;
+const int DEAL_CELLS_MAX = 400; // Larger boards can take too long to prove
+const std::uint32_t DEALS_VERSION = 1; // Bump if dealing ever changes
+
+
+enum class DealVerdict { Solvable, Dead, Unwinnable, Undecided };
+
+
+struct DealStats {
+    double rejectionRate() const {
+        return candidates ? 1 - static_cast<double>(accepted) / candidates
+                          : 0;
+    }
+
+    long long candidates = 0;
+    long long accepted = 0; // Proven solvable
+    long long pooled = 0; // Accepted while the pool had room for them
+    long long dead = 0; // Lost as dealt
+    long long unwinnable = 0; // Proven unwinnable by the solver
+    long long undecided = 0; // Not proven either way within maxNodes
+    double seconds = 0; // Spent checking, summed over every thread
+};
+
+
+DealVerdict checkDeal(const Engine& engine, Solver& solver,
+                      long long maxNodes=DEAL_MAX_NODES);
+
+
+class Dealer {
+public:
+    explicit Dealer(int threads=0, long long maxNodes=DEAL_MAX_NODES);
+    ~Dealer();
+
+    Dealer(const Dealer&) = delete;
+    Dealer& operator=(const Dealer&) = delete;
+
+    static bool canProve(const Configuration& configuration) {
+        return configuration.columns * configuration.rows <= DEAL_CELLS_MAX;
+    }
+
+    void fill(const Configuration& configuration, int count=DEAL_POOL_SIZE);
+    // Returns a solvable seed, if one is ready, and tops the pool up
+    std::optional<unsigned> take(const Configuration& configuration);
+    int ready(const Configuration& configuration) const;
+    DealStats stats(const Configuration& configuration) const;
+    void wait(); // Until every pool is filled
+
+    bool load(const std::string& filename);
+    bool save(const std::string& filename) const;
+
+private:
+    struct State;
+
+    void submit(std::shared_ptr<State> state, Configuration configuration);
+
+    std::shared_ptr<State> state; // Shared with the tasks
+    ThreadPool pool; // Last so that its workers stop first
+};
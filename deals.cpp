@@ -0,0 +1,128 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    Generates solvable deals: scons gravitate-deals && ./gravitate-deals
+        [options]
+    Fills a pool of proven-winnable deals for each board size and color
+    count on every core and prints, as CSV, how quickly they were found
+    and why the other candidates were rejected. --pool adds the deals to
+    a pool file, e.g., Gravitate's deals.grvd, so that it starts full.
+*/
+
+#include "dealer.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* USAGE =
+    "usage: gravitate-deals [--deals N] [--sizes CxR[,CxR...]]\n"
+    "    [--colors K[,K...]] [--max-nodes N] [--threads T] [--pool FILE]\n";
+
+struct Options {
+    int deals = 100;
+    std::vector<std::pair<int, int>> sizes{{9, 9}};
+    std::vector<int> colors{4};
+    long long maxNodes = DEAL_MAX_NODES;
+    int threads = 0;
+    std::string pool; // Deals file to add to, if wanted
+};
+
+
+bool parse(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg(argv[i]);
+        if (i + 1 == argc)
+            return false;
+        const char* value = argv[++i];
+        if (arg == "--deals")
+            options.deals = std::atoi(value);
+        else if (arg == "--sizes") {
+            options.sizes.clear();
+            for (const char* p = value; *p; ) {
+                int columns;
+                int rows;
+                int length;
+                if (std::sscanf(p, "%dx%d%n", &columns, &rows, &length) != 2)
+                    return false;
+                options.sizes.push_back({columns, rows});
+                p += length;
+                if (*p == ',')
+                    ++p;
+            }
+        }
+        else if (arg == "--colors") {
+            options.colors.clear();
+            for (const char* p = value; *p; ) {
+                char* end;
+                options.colors.push_back(std::strtol(p, &end, 10));
+                if (end == p)
+                    return false;
+                p = *end == ',' ? end + 1 : end;
+            }
+        }
+        else if (arg == "--max-nodes")
+            options.maxNodes = std::atoll(value);
+        else if (arg == "--threads")
+            options.threads = std::atoi(value);
+        else if (arg == "--pool")
+            options.pool = value;
+        else
+            return false;
+    }
+    for (const auto& size: options.sizes)
+        if (size.first < 1 || size.second < 1 ||
+                !Dealer::canProve({size.first, size.second, 2}))
+            return false;
+    for (const int colors: options.colors)
+        if (colors < 2 || colors > PALETTE_SIZE)
+            return false;
+    return options.deals > 0 && options.maxNodes > 0;
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse(argc, argv, options)) {
+        std::fprintf(stderr, "%s", USAGE);
+        return 2;
+    }
+    Dealer dealer(options.threads, options.maxNodes);
+    if (!options.pool.empty())
+        dealer.load(options.pool); // A missing pool file is started afresh
+    std::printf("columns,rows,colors,deals,candidates,dead,unwinnable,"
+                "undecided,rejection_rate,deals_per_second,seconds\n");
+    for (const auto& size: options.sizes)
+        for (const int colors: options.colors) {
+            const Configuration configuration{size.first, size.second,
+                                              colors};
+            const auto start = Clock::now();
+            dealer.fill(configuration,
+                        dealer.ready(configuration) + options.deals);
+            dealer.wait();
+            const double seconds = std::chrono::duration<double>(
+                Clock::now() - start).count();
+            const auto stats = dealer.stats(configuration);
+            std::printf("%d,%d,%d,%lld,%lld,%lld,%lld,%lld,%.4f,%.1f,%.3f\n",
+                        size.first, size.second, colors, stats.pooled,
+                        stats.candidates, stats.dead, stats.unwinnable,
+                        stats.undecided, stats.rejectionRate(),
+                        stats.pooled / seconds, seconds);
+            std::fflush(stdout);
+        }
+    if (!options.pool.empty() && !dealer.save(options.pool)) {
+        std::fprintf(stderr, "failed to write %s\n", options.pool.c_str());
+        return 1;
+    }
+}
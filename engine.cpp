@@ -0,0 +1,480 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include "engine.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+
+namespace {
+
+// Directions in the order left, right, up, down; d ^ 1 is d's opposite
+const int DX[]{-1, 1, 0, 0};
+const int DY[]{0, 0, -1, 1};
+
+const Cell QUEUED = 0x10;
+
+const Score SCORE_MAX = std::numeric_limits<Score>::max();
+
+// The Zobrist key for a cell of the given color, computed (splitmix64)
+// rather than looked up so that huge boards need no table
+std::uint64_t zobrist(int i, int color) {
+    std::uint64_t z = static_cast<std::uint64_t>(i) *
+                      (MAX_COLOR_INDEX + 1) + color + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+
+// A tile has left this cell in direction d
+Cell leftBit(int d) { return static_cast<Cell>(1 << d); }
+
+int direction(const Point from, const Point to) {
+    if (to.x != from.x)
+        return to.x < from.x ? 0 : 1;
+    return to.y < from.y ? 2 : 3;
+}
+
+} // namespace
+
+
+Engine::Engine(unsigned seed)
+        : columns_(0), rows_(0), maxColors_(0), score_(0),
+          state_(GameState::Lost), hash_(0), seed_(0), undoable_(true),
+          randomizer_(seed) {}
+
+
+void Engine::newGame(int columns, int rows, int maxColors) {
+    newGame(columns, rows, maxColors,
+            static_cast<unsigned>(randomizer_() >> 32));
+}
+
+
+// The same seed always deals the same board. A deal can be over before
+// it starts, e.g., if it has no legal move or a color with only one tile.
+void Engine::newGame(int columns, int rows, int maxColors, unsigned seed) {
+    TRACE_SCOPE("engine/newGame");
+    reset(columns, rows, maxColors);
+    seed_ = seed;
+    Randomizer dealer(seed);
+    palette_.clear();
+    for (int i = 0; i < PALETTE_SIZE; ++i)
+        palette_.push_back(i);
+    dealer.shuffle(palette_.begin(), palette_.end());
+    palette_.resize(maxColors);
+    for (int x = 0; x < columns; ++x)
+        for (int y = 0; y < rows; ++y)
+            setCell(x, y, static_cast<Cell>(dealer.between(1, maxColors)));
+    components.build(tiles);
+    state_ = checkTiles();
+}
+
+
+// Resumes a saved game from its row-major cells, e.g., a snapshot's.
+// Returns false (and changes nothing) if the cells, palette, or history
+// don't fit the board.
+bool Engine::restore(int columns, int rows, const PaletteIndexes& palette,
+                     const Cell* cells, Score score, unsigned seed,
+                     Points history) {
+    const int maxColors = static_cast<int>(palette.size());
+    if (columns < 1 || rows < 1 || maxColors < 2 ||
+            maxColors > PALETTE_SIZE || score < 0)
+        return false;
+    for (const int index: palette)
+        if (index < 0 || index >= PALETTE_SIZE)
+            return false;
+    const size_t size = static_cast<size_t>(columns) * rows;
+    if (std::any_of(cells, cells + size, [&](Cell cell) {
+            return cell > maxColors; }))
+        return false;
+    for (const auto& point: history)
+        if (point.x < 0 || point.x >= columns || point.y < 0 ||
+                point.y >= rows)
+            return false;
+    reset(columns, rows, maxColors);
+    palette_ = palette;
+    score_ = score;
+    seed_ = seed;
+    history_ = std::move(history);
+    for (int y = 0; y < rows; ++y)
+        for (int x = 0; x < columns; ++x) {
+            const Cell cell = cells[tiles.index(x, y)];
+            if (cell != NO_COLOR)
+                setCell(x, y, cell);
+        }
+    components.build(tiles);
+    state_ = checkTiles();
+    return true;
+}
+
+
+// Empties the board, resizing it if need be
+void Engine::reset(int columns, int rows, int maxColors) {
+    const bool resized = columns != columns_ || rows != rows_;
+    columns_ = columns;
+    rows_ = rows;
+    maxColors_ = maxColors;
+    score_ = 0;
+    state_ = GameState::Playing;
+    hash_ = 0;
+    history_.clear();
+    undos.clear();
+    undoCells.clear();
+    redos.clear();
+    tiles.reset(columns, rows);
+    settleFlags.assign(tiles.size(), 0);
+    if (resized) {
+        radii.resize(tiles.size());
+        for (int y = 0; y < rows; ++y)
+            for (int x = 0; x < columns; ++x)
+                radii[tiles.index(x, y)] = std::hypot(columns / 2 - x,
+                                                      rows / 2 - y);
+    }
+    planes.assign(maxColors + 1, Bitboard(columns, rows));
+}
+
+
+// Removes the group at point, closes the tiles up, and updates the score
+// and game state. Returns an invalid result (and changes nothing) if the
+// click is not legal. The result's moves are only filled in if
+// recordMoves is true, e.g., for a view to animate. A new move can't be
+// redone after, so it forgets any undone moves.
+MoveResult Engine::apply(const Point point, bool recordMoves) {
+    auto result = play(point, recordMoves);
+    if (result.isValid())
+        redos.clear();
+    return result;
+}
+
+
+MoveResult Engine::play(const Point point, bool recordMoves) {
+    TRACE_SCOPE("engine/apply");
+    MoveResult result;
+    if (state_ != GameState::Playing || !isLegal(point))
+        return result;
+    const Score score = score_;
+    result.removed = adjoining(point);
+    const Cell color = tiles.at(point.x, point.y);
+    for (const auto& p: result.removed)
+        setCell(p.x, p.y, NO_COLOR);
+    moves.clear();
+    moveTiles(result.removed, moves);
+    changed = result.removed;
+    for (const auto& move: moves) {
+        changed.push_back(move.from);
+        changed.push_back(move.to);
+    }
+    components.update(tiles, changed, undoable_);
+    if (undoable_) {
+        undos.push_back({point, color, score,
+                         static_cast<std::uint32_t>(result.removed.size()),
+                         static_cast<std::uint32_t>(moves.size())});
+        for (const auto& p: result.removed)
+            undoCells.push_back(static_cast<std::uint32_t>(
+                tiles.index(p.x, p.y)));
+        for (const auto& move: moves)
+            undoCells.push_back(static_cast<std::uint32_t>(
+                tiles.index(move.from.x, move.from.y) * 4 +
+                direction(move.from, move.to)));
+    }
+    if (recordMoves)
+        result.moves = moves;
+    history_.push_back(point);
+    result.scoreDelta = groupScore(static_cast<int>(result.removed.size()));
+    score_ = score_ > SCORE_MAX - result.scoreDelta
+        ? SCORE_MAX : score_ + result.scoreDelta;
+    state_ = result.state = checkTiles();
+    return result;
+}
+
+
+// Takes back the last move, restoring the board, score, and state (even
+// of a finished game); returns false if there is no move to undo. The
+// tiles are moved back in the reverse of the order they moved.
+bool Engine::undo() {
+    TRACE_SCOPE("engine/undo");
+    if (undos.empty())
+        return false;
+    const auto undo = undos.back();
+    undos.pop_back();
+    for (std::uint32_t k = 0; k < undo.moved; ++k) {
+        const auto code = undoCells.back();
+        undoCells.pop_back();
+        const int i = static_cast<int>(code / 4);
+        const int d = static_cast<int>(code % 4);
+        const Point from(i % columns_, i / columns_);
+        const Point to(from.x + DX[d], from.y + DY[d]);
+        setCell(from.x, from.y, tiles.at(to.x, to.y));
+        setCell(to.x, to.y, NO_COLOR);
+    }
+    for (std::uint32_t k = 0; k < undo.removed; ++k) {
+        const int i = static_cast<int>(undoCells.back());
+        undoCells.pop_back();
+        const Point point(i % columns_, i / columns_);
+        setCell(point.x, point.y, undo.color);
+    }
+    components.undo();
+    score_ = undo.score;
+    state_ = GameState::Playing;
+    history_.pop_back();
+    redos.push_back(undo.point);
+    return true;
+}
+
+
+// Replays the last undone move; returns an invalid result if there is
+// none
+MoveResult Engine::redo(bool recordMoves) {
+    if (redos.empty())
+        return MoveResult();
+    const auto point = redos.back();
+    redos.pop_back();
+    return play(point, recordMoves);
+}
+
+
+// E.g., for games that are only played forwards such as playouts, which
+// then needn't log anything; turning undo off forgets the logged moves
+void Engine::setUndoable(bool undoable) {
+    undoable_ = undoable;
+    if (!undoable) {
+        undos.clear();
+        undoCells.clear();
+        redos.clear();
+        components.forgetUndos();
+    }
+}
+
+
+bool Engine::isLegal(const Point point) const {
+    return tiles.contains(point.x, point.y) &&
+        components.isLegal(point.x, point.y);
+}
+
+
+int Engine::groupSize(const Point point) const {
+    return tiles.contains(point.x, point.y) ?
+        components.size(point.x, point.y) : 0;
+}
+
+
+bool Engine::isLegal(const Point point, int color) const {
+    // A legal click is on a colored tile that is adjacent to another
+    // tile of the same color.
+    const auto& x = point.x;
+    const auto& y = point.y;
+    const int i = tiles.index(x, y);
+    if (x > 0 && (tiles[i - 1] & COLOR_MASK) == color)
+        return true;
+    if (x + 1 < columns_ && (tiles[i + 1] & COLOR_MASK) == color)
+        return true;
+    if (y > 0 && (tiles[i - columns_] & COLOR_MASK) == color)
+        return true;
+    if (y + 1 < rows_ && (tiles[i + columns_] & COLOR_MASK) == color)
+        return true;
+    return false;
+}
+
+
+Points Engine::adjoining(const Point point) const {
+    TRACE_SCOPE("engine/adjoining");
+    Points adjoining;
+    if (isLegal(point))
+        planes[color(point)].group(point.x, point.y).forEach(
+            [&](int x, int y) { adjoining.push_back(Point(x, y)); });
+    return adjoining;
+}
+
+
+// All changes to tiles must go through here to keep the planes and the
+// hash in step
+void Engine::setCell(int x, int y, Cell cell) {
+    const int i = tiles.index(x, y);
+    const int oldColor = tiles.color(x, y);
+    if (oldColor != NO_COLOR) {
+        planes[oldColor].clear(x, y);
+        hash_ ^= zobrist(i, oldColor);
+    }
+    tiles[i] = cell;
+    const int newColor = cell & COLOR_MASK;
+    if (newColor != NO_COLOR) {
+        planes[newColor].set(x, y);
+        hash_ ^= zobrist(i, newColor);
+    }
+}
+
+
+// Moves tiles towards the middle until none can move. A tile's move only
+// depends on which of its neighbours are empty (nearestToMiddle's isSquare
+// and isLegal tests always pass for a neighbour of a colored tile), so
+// only tiles next to a cell that has just been emptied need (re)checking:
+// initially those around the removed tiles, and then those around each
+// cell a tile leaves, plus the moved tile itself. The work done is
+// proportional to the tiles that move. The initial order is shuffled so
+// that tiles ripple in, but seeded from the board so that the outcome is
+// always the same for the same board.
+void Engine::moveTiles(const Points& removed, TileMoves& tileMoves) {
+    TRACE_SCOPE("engine/moveTiles");
+    for (const auto& point: removed)
+        enqueueNeighbours(point);
+    Randomizer ripple(hash_);
+    ripple.shuffle(frontier.begin(), frontier.end());
+    for (size_t head = 0; head < frontier.size(); ++head) {
+        const int i = frontier[head];
+        settleFlags[i] &= ~QUEUED;
+        const Point point(i % columns_, i / columns_);
+        if (tiles.isEmpty(point.x, point.y))
+            continue;
+        const auto newPoint = nextMove(point);
+        if (!newPoint.isValid())
+            continue;
+        setCell(newPoint.x, newPoint.y, tiles.at(point.x, point.y));
+        setCell(point.x, point.y, NO_COLOR);
+        if (!settleFlags[i])
+            flagged.push_back(i);
+        settleFlags[i] |= leftBit(direction(point, newPoint));
+        tileMoves.push_back({point, newPoint});
+        enqueue(newPoint.x, newPoint.y);
+        enqueueNeighbours(point);
+    }
+    frontier.clear();
+    for (const int i: flagged)
+        settleFlags[i] = 0;
+    flagged.clear();
+}
+
+
+void Engine::enqueue(int x, int y) {
+    if (!tiles.contains(x, y) || tiles.isEmpty(x, y))
+        return;
+    const int i = tiles.index(x, y);
+    if (settleFlags[i] & QUEUED)
+        return;
+    if (!settleFlags[i])
+        flagged.push_back(i);
+    settleFlags[i] |= QUEUED;
+    frontier.push_back(i);
+}
+
+
+void Engine::enqueueNeighbours(const Point point) {
+    for (int d = 0; d < 4; ++d)
+        enqueue(point.x + DX[d], point.y + DY[d]);
+}
+
+
+// Returns where the tile at point should move to, or an invalid point if
+// it should stay put
+Point Engine::nextMove(const Point point) const {
+    Point empties[4];
+    const int count = getEmptyNeighbours(point, empties);
+    if (count) {
+        bool move;
+        const auto newPoint = nearestToMiddle(point, empties, count, &move);
+        if (move && !isBlocked(point, newPoint))
+            return newPoint;
+    }
+    return Point();
+}
+
+
+// Avoid endless loops: a tile may never move back along an edge a tile
+// has just crossed, and a move that gets no nearer the middle (the same
+// color attraction allows these) may only cross each edge once. Since
+// every other move reduces the tiles' total distance from the middle,
+// settling always finishes.
+bool Engine::isBlocked(const Point point, const Point newPoint) const {
+    const int d = direction(point, newPoint);
+    const int i = tiles.index(point.x, point.y);
+    const int j = tiles.index(newPoint.x, newPoint.y);
+    if (settleFlags[j] & leftBit(d ^ 1))
+        return true;
+    return radius(newPoint) >= radius(point) && (settleFlags[i] & leftBit(d));
+}
+
+
+int Engine::getEmptyNeighbours(const Point point, Point* empties) const {
+    int count = 0;
+    for (int d = 0; d < 4; ++d) {
+        const Point newPoint(point.x + DX[d], point.y + DY[d]);
+        if (tiles.contains(newPoint.x, newPoint.y) &&
+                tiles.isEmpty(newPoint.x, newPoint.y))
+            empties[count++] = newPoint;
+    }
+    return count;
+}
+
+
+Point Engine::nearestToMiddle(const Point point, const Point* empties,
+                              int count, bool* move) const {
+    const auto color = tiles.color(point.x, point.y);
+    const double oldRadius = radius(point);
+    double shortestRadius = NAN;
+    Point radiusPoint;
+    for (int k = 0; k < count; ++k) {
+        const auto& newPoint = empties[k];
+        if (isSquare(newPoint)) {
+            double newRadius = radius(newPoint);
+            if (isLegal(newPoint, color))
+                newRadius -= 0.1; // Make same colors slightly attract
+            if (!radiusPoint.isValid() || shortestRadius > newRadius) {
+                shortestRadius = newRadius;
+                radiusPoint = newPoint;
+            }
+        }
+    }
+    if (!std::isnan(shortestRadius) && oldRadius > shortestRadius) {
+        *move = true;
+        return radiusPoint;
+    }
+    *move = false;
+    return point;
+}
+
+
+bool Engine::isSquare(const Point& point) const {
+    const auto x = point.x;
+    const auto y = point.y;
+    const int i = tiles.index(x, y);
+    if (x > 0 && (tiles[i - 1] & COLOR_MASK) != NO_COLOR)
+        return true;
+    if (x + 1 < columns_ && (tiles[i + 1] & COLOR_MASK) != NO_COLOR)
+        return true;
+    if (y > 0 && (tiles[i - columns_] & COLOR_MASK) != NO_COLOR)
+        return true;
+    if (y + 1 < rows_ && (tiles[i + columns_] & COLOR_MASK) != NO_COLOR)
+        return true;
+    return false;
+}
+
+
+// Returns round(√(columns × rows)) + count^(maxColors / 2), saturating
+// rather than overflowing for the huge groups of huge boards
+Score Engine::groupScore(int count) const {
+    Score score = static_cast<Score>(
+        std::round(std::sqrt(static_cast<double>(columns_) * rows_)));
+    Score power = 1;
+    for (int i = 0; i < maxColors_ / 2; ++i) {
+        if (power > SCORE_MAX / count)
+            return SCORE_MAX;
+        power *= count;
+    }
+    return power > SCORE_MAX - score ? SCORE_MAX : score + power;
+}
+
+
+// The game is won if there are no tiles left, and lost if no two tiles of
+// the same color adjoin or if any color has only a single tile left
+GameState Engine::checkTiles() const {
+    if (components.tileCount() == 0)
+        return GameState::Won;
+    if (components.legalMoveCount() == 0 || components.hasSingletonColor())
+        return GameState::Lost;
+    return GameState::Playing;
+}
+
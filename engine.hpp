@@ -0,0 +1,181 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    The game rules with no wx dependency: the Engine applies a click to its
+    board at full speed and reports what happened so that a view (e.g.,
+    BoardWidget) can animate it afterwards.
+
+    The board's Zobrist hash is kept up to date by every cell change,
+    including each tile move of the settle pass. The settle pass's ripple
+    order is seeded from the hash, so a move's outcome depends only on the
+    board and the click, and equal boards are true transpositions.
+
+    Every move can be undone: the undo log keeps just what the move
+    changed (the removed cells and each tile move), so its memory and the
+    time to undo a move are proportional to the tiles changed, which also
+    makes apply() and undo() a cheap make/unmake pair for searches. Since
+    moves are deterministic, redo simply replays the undone click.
+*/
+
+#include "bitboard.hpp"
+#include "components.hpp"
+#include "grid.hpp"
+#include "palette.hpp"
+#include "random.hpp"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+
+using Score = std::int64_t;
+
+// The most columns or rows a board can have, which bounds what loading a
+// file can allocate
+const int BOARD_SIZE_MAX = 2000;
+
+
+struct TileMove {
+    Point from;
+    Point to;
+};
+
+using TileMoves = std::vector<TileMove>;
+
+
+enum class GameState { Playing, Won, Lost };
+
+
+struct MoveResult {
+    bool isValid() const { return !removed.empty(); }
+
+    Points removed;
+    TileMoves moves; // In the order they were made
+    Score scoreDelta = 0;
+    GameState state = GameState::Playing;
+};
+
+
+// A board size and color count, e.g., to key per-configuration data
+struct Configuration {
+    int columns;
+    int rows;
+    int maxColors;
+};
+
+
+inline bool operator==(const Configuration& a, const Configuration& b) {
+    return a.columns == b.columns && a.rows == b.rows &&
+           a.maxColors == b.maxColors;
+}
+
+
+inline bool operator<(const Configuration& a, const Configuration& b) {
+    if (a.columns != b.columns)
+        return a.columns < b.columns;
+    if (a.rows != b.rows)
+        return a.rows < b.rows;
+    return a.maxColors < b.maxColors;
+}
+
+
+class Engine {
+public:
+    explicit Engine(unsigned seed=std::random_device{}());
+
+    void newGame(int columns, int rows, int maxColors);
+    void newGame(int columns, int rows, int maxColors, unsigned seed);
+    bool restore(int columns, int rows, const PaletteIndexes& palette,
+                 const Cell* cells, Score score, unsigned seed,
+                 Points history);
+    MoveResult apply(const Point point, bool recordMoves=true);
+    bool undo();
+    MoveResult redo(bool recordMoves=true);
+    bool canUndo() const { return !undos.empty(); }
+    bool canRedo() const { return !redos.empty(); }
+    void setUndoable(bool undoable);
+
+    bool isLegal(const Point point) const;
+    Points adjoining(const Point point) const;
+    int groupSize(const Point point) const;
+    int largestGroup() const { return components.largest(); }
+    int legalMoveCount() const { return components.legalMoveCount(); }
+    int colorCount(int color) const { return components.colorCount(color); }
+    void legalMoves(Points& moves) const { components.legalMoves(moves); }
+
+    int columns() const { return columns_; }
+    int rows() const { return rows_; }
+    int maxColors() const { return maxColors_; }
+    Score score() const { return score_; }
+    GameState state() const { return state_; }
+    std::uint64_t hash() const { return hash_; }
+    Score groupScore(int count) const;
+    int color(int x, int y) const { return tiles.color(x, y); }
+    int color(const Point point) const {
+        return tiles.color(point.x, point.y);
+    }
+    const Grid& grid() const { return tiles; }
+    const PaletteIndexes& palette() const { return palette_; }
+    unsigned seed() const { return seed_; } // The deal's seed
+    const Points& history() const { return history_; } // Clicks applied
+    const Randomizer& randomizer() const { return randomizer_; }
+    void setRandomizer(const Randomizer& randomizer) {
+        randomizer_ = randomizer;
+    }
+
+private:
+    struct Undo {
+        Point point; // The click
+        Cell color; // The removed group's color
+        Score score; // Before the move
+        std::uint32_t removed; // How many undoCells are removed cells
+        std::uint32_t moved; // How many undoCells follow for tile moves
+    };
+
+    void reset(int columns, int rows, int maxColors);
+    MoveResult play(const Point point, bool recordMoves);
+    bool isLegal(const Point point, int color) const;
+    void setCell(int x, int y, Cell cell);
+    void moveTiles(const Points& removed, TileMoves& tileMoves);
+    void enqueue(int x, int y);
+    void enqueueNeighbours(const Point point);
+    Point nextMove(const Point point) const;
+    bool isBlocked(const Point point, const Point newPoint) const;
+    int getEmptyNeighbours(const Point point, Point* empties) const;
+    Point nearestToMiddle(const Point point, const Point* empties,
+                          int count, bool* move) const;
+    double radius(const Point point) const {
+        return radii[tiles.index(point.x, point.y)];
+    }
+    bool isSquare(const Point& point) const;
+    GameState checkTiles() const;
+
+    int columns_;
+    int rows_;
+    int maxColors_;
+    Score score_;
+    GameState state_;
+    std::uint64_t hash_;
+    unsigned seed_;
+    PaletteIndexes palette_;
+    Points history_;
+    Grid tiles;
+    std::vector<Bitboard> planes; // Indexed by color; kept in step with tiles
+    Components components;
+    Points changed; // Scratch space for the cells a move changes
+    TileMoves moves; // Scratch space used if the caller wants no moves
+    std::vector<int> frontier; // Cells whose tiles might be able to move
+    std::vector<Cell> settleFlags; // Per cell: QUEUED and LEFT_* bits
+    std::vector<int> flagged; // Cells with nonzero settleFlags
+    std::vector<double> radii; // Per cell: its distance from the middle
+    bool undoable_;
+    std::vector<Undo> undos;
+    // Per undo: its removed cells' indexes and then its tile moves, each
+    // as the from cell's index × 4 + the direction moved
+    std::vector<std::uint32_t> undoCells;
+    Points redos; // Undone clicks, the next to redo last
+    Randomizer randomizer_; // For choosing each deal's seed
+};
+
@@ -0,0 +1,98 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    A flat, row-major board of one byte per cell. The low bits of a cell
+    hold a color index (NO_COLOR for an empty cell) and the high bits hold
+    state flags such as DIMMED; colors are only resolved to real colors
+    when painting.
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+
+using Cell = std::uint8_t;
+
+const Cell NO_COLOR = 0; // Colors are 1..maxColors; 0 is an empty cell
+const Cell COLOR_MASK = 0x0F;
+const Cell DIMMED = 0x10;
+const Cell HINTED = 0x20; // Only used by views
+const int MAX_COLOR_INDEX = COLOR_MASK;
+const int INVALID_POS = -1;
+
+
+struct Point {
+    Point(int x_=INVALID_POS, int y_=INVALID_POS) : x(x_), y(y_) {}
+
+    bool isValid() const { return x != INVALID_POS && y != INVALID_POS; }
+
+    int x;
+    int y;
+};
+
+
+inline bool operator==(const Point& a, const Point& b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+
+namespace std {
+    template<> struct hash<Point> {
+        size_t operator()(const Point& xy) const noexcept {
+            return std::hash<int>{}(xy.x) ^ (std::hash<int>{}(xy.y) << 1);
+        }
+    };
+}
+
+
+using Points = std::vector<Point>;
+
+
+class Grid {
+public:
+    Grid() : columns_(0), rows_(0) {}
+
+    void reset(int columns, int rows, Cell cell=NO_COLOR) {
+        columns_ = columns;
+        rows_ = rows;
+        cells.assign(static_cast<size_t>(columns) * rows, cell);
+    }
+
+    int columns() const { return columns_; }
+    int rows() const { return rows_; }
+    int size() const { return static_cast<int>(cells.size()); }
+    bool empty() const { return cells.empty(); }
+
+    bool contains(int x, int y) const {
+        return 0 <= x && x < columns_ && 0 <= y && y < rows_;
+    }
+    int index(int x, int y) const { return y * columns_ + x; }
+
+    Cell& at(int x, int y) { return cells[index(x, y)]; }
+    Cell at(int x, int y) const { return cells[index(x, y)]; }
+    Cell& operator[](int i) { return cells[i]; }
+    Cell operator[](int i) const { return cells[i]; }
+
+    int color(int x, int y) const { return at(x, y) & COLOR_MASK; }
+    bool isEmpty(int x, int y) const { return color(x, y) == NO_COLOR; }
+    bool isDimmed(int x, int y) const { return at(x, y) & DIMMED; }
+    bool isHinted(int x, int y) const { return at(x, y) & HINTED; }
+
+    const Cell* data() const { return cells.data(); }
+
+private:
+    int columns_;
+    int rows_;
+    std::vector<Cell> cells;
+};
+
+
+inline bool operator==(const Grid& a, const Grid& b) {
+    return a.columns() == b.columns() && a.rows() == b.rows() &&
+        std::equal(a.data(), a.data() + a.size(), b.data());
+}
@@ -39,15 +39,31 @@ tiles falling to the bottom and moving off to the left, they
 <tr><td><font color="#004E00">Key</font></td>
     <td><font color="#004E00">Action</font></td></tr>
 <tr><td><b>a</b></td><td>Show About box</td></tr>
+<tr><td><b>e</b></td><td>Export the board as a PNG image</td></tr>
 <tr><td><b>h</b> or <b>F1</b></td><td>Show Help (this window)</td></tr>
+<tr><td><b>i</b></td><td>Hint: highlight the best group to click</td></tr>
+<tr><td><b>l</b></td><td>Show statistics and the leaderboard for the
+board size and colors</td></tr>
 <tr><td><b>n</b></td><td>New game</td></tr>
 <tr><td><b>o</b></td><td>View or edit options</td></tr>
 <tr><td><b>q</b></td><td>Quit</td></tr>
+<tr><td><b>r</b></td><td>Redo the last undone move</td></tr>
+<tr><td><b>s</b></td><td>Play a seed: deal a new game from its
+number</td></tr>
+<tr><td><b>u</b></td><td>Undo the last move</td></tr>
 <tr><td><b>←</b></td><td>Move focus left</td></tr>
 <tr><td><b>→</b></td><td>Move focus right</td></tr>
 <tr><td><b>↑</b></td><td>Move focus up</td></tr>
 <tr><td><b>↓</b></td><td>Move focus down</td></tr>
 <tr><td><b>Space</b></td><td>Click focused tile</td></tr>
+<tr><td><b>+</b> or <b>Ctrl+Wheel</b></td><td>Zoom in</td></tr>
+<tr><td><b>−</b> or <b>Ctrl+Wheel</b></td><td>Zoom out</td></tr>
+<tr><td><b>0</b></td><td>Fit the board to the window</td></tr>
+<tr><td><b>Wheel</b>, <b>PgUp</b>, <b>PgDn</b></td><td>Scroll up or
+down</td></tr>
+<tr><td><b>Shift+Wheel</b></td><td>Scroll left or right</td></tr>
+<tr><td><b>Home</b></td><td>Scroll to the top-left</td></tr>
+<tr><td>Right or middle drag</td><td>Pan a large board</td></tr>
 </table>
 </body></html>)RAW");
 
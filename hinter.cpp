@@ -0,0 +1,254 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include "hinter.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const int BATCH = 8; // Playouts per task between merging statistics
+
+struct Stats {
+    void add(Score score, bool won) {
+        ++playouts;
+        wins += won;
+        totalScore += static_cast<double>(score);
+    }
+    void add(const Stats& other) {
+        playouts += other.playouts;
+        wins += other.wins;
+        totalScore += other.totalScore;
+    }
+
+    long long playouts = 0;
+    long long wins = 0;
+    double totalScore = 0;
+};
+
+using Replies = std::unordered_map<int, Stats>; // By grid index of move
+
+struct Outcome {
+    int reply; // Grid index of the second move, or INVALID_POS if none
+    Score score;
+    bool won;
+};
+
+} // namespace
+
+
+struct Hinter::Search {
+    bool isOver() const {
+        return cancelled || Clock::now() >= deadline;
+    }
+    bool playout(int candidate, Randomizer& random, Engine& game,
+                 Points& moves, Outcome& outcome) const;
+
+    Engine root;
+    Points moves; // One per candidate
+    std::vector<int> sizes;
+    std::vector<Stats> stats;
+    std::vector<Replies> replies;
+    Clock::time_point deadline;
+    std::atomic<bool> cancelled{false};
+    std::atomic<unsigned> seeds{0};
+    mutable std::mutex mutex; // Guards stats and replies
+};
+
+
+// The statistics for the position reached by the move the player made
+struct Hinter::Kept {
+    Grid grid;
+    Replies replies;
+};
+
+
+Hinter::Hinter(int threads) : pool(threads) {}
+
+
+Hinter::~Hinter() {
+    cancel();
+}
+
+
+// Any search that is running is cancelled; if the engine's board is the
+// one reached by the move last passed to played(), the statistics already
+// gathered for it are carried over
+void Hinter::start(const Engine& engine, int budgetMs) {
+    cancel();
+    auto newSearch = std::make_shared<Search>();
+    newSearch->root = engine;
+    newSearch->root.setUndoable(false); // Playouts copy it and never undo
+    newSearch->seeds = std::random_device{}();
+    if (engine.state() == GameState::Playing)
+        engine.legalMoves(newSearch->moves);
+    const auto& moves = newSearch->moves;
+    newSearch->stats.resize(moves.size());
+    newSearch->replies.resize(moves.size());
+    const bool reuse = kept && kept->grid == engine.grid();
+    for (size_t i = 0; i < moves.size(); ++i) {
+        newSearch->sizes.push_back(engine.groupSize(moves[i]));
+        if (reuse) {
+            const auto it = kept->replies.find(
+                engine.grid().index(moves[i].x, moves[i].y));
+            if (it != kept->replies.end())
+                newSearch->stats[i] = it->second;
+        }
+    }
+    kept.reset();
+    newSearch->deadline = Clock::now() + std::chrono::milliseconds(
+        budgetMs);
+    search = newSearch;
+    for (int i = 0; i < static_cast<int>(moves.size()); ++i)
+        submit(search, i);
+}
+
+
+// Returns at once: the search's tasks notice and stop within a playout
+void Hinter::cancel() {
+    if (search)
+        search->cancelled = true;
+}
+
+
+// Call this after the engine has applied the player's move at point
+void Hinter::played(const Point point, const Engine& engine) {
+    cancel();
+    kept.reset();
+    if (!search)
+        return;
+    const auto group = search->root.adjoining(point);
+    if (group.empty())
+        return;
+    const auto& moves = search->moves;
+    const auto it = std::find(moves.cbegin(), moves.cend(), group.front());
+    if (it == moves.cend())
+        return;
+    kept = std::make_unique<Kept>();
+    kept->grid = engine.grid();
+    std::lock_guard<std::mutex> lock(search->mutex);
+    kept->replies = search->replies[it - moves.cbegin()];
+}
+
+
+bool Hinter::isRunning() const {
+    return search && !search->isOver();
+}
+
+
+Hints Hinter::hints() const {
+    Hints hints;
+    if (!search)
+        return hints;
+    {
+        std::lock_guard<std::mutex> lock(search->mutex);
+        for (size_t i = 0; i < search->moves.size(); ++i) {
+            const auto& stats = search->stats[i];
+            Hint hint;
+            hint.point = search->moves[i];
+            hint.size = search->sizes[i];
+            hint.playouts = stats.playouts;
+            if (stats.playouts) {
+                hint.meanScore = stats.totalScore / stats.playouts;
+                hint.winRate = static_cast<double>(stats.wins) /
+                               stats.playouts;
+            }
+            hints.push_back(hint);
+        }
+    }
+    std::stable_sort(hints.begin(), hints.end(),
+                     [](const Hint& a, const Hint& b) {
+        if ((a.playouts > 0) != (b.playouts > 0))
+            return a.playouts > 0;
+        if (a.winRate != b.winRate)
+            return a.winRate > b.winRate;
+        if (a.meanScore != b.meanScore)
+            return a.meanScore > b.meanScore;
+        return a.size > b.size;
+    });
+    return hints;
+}
+
+
+Hint Hinter::best() const {
+    const auto all = hints();
+    return all.empty() ? Hint() : all.front();
+}
+
+
+long long Hinter::playouts() const {
+    long long count = 0;
+    if (search) {
+        std::lock_guard<std::mutex> lock(search->mutex);
+        for (const auto& stats: search->stats)
+            count += stats.playouts;
+    }
+    return count;
+}
+
+
+// Each task plays a batch of games from one candidate, merges the results,
+// and then resubmits itself onto its own worker's queue until the search
+// is over; idle workers steal queued candidates from busy ones
+void Hinter::submit(std::shared_ptr<Search> search, int candidate) {
+    pool.submit([this, search, candidate]() {
+        TRACE_SCOPE("hinter/batch");
+        thread_local Randomizer random;
+        thread_local Engine game;
+        thread_local Points moves;
+        thread_local std::vector<Outcome> outcomes;
+        random.seed(search->seeds++);
+        outcomes.clear();
+        Outcome outcome;
+        for (int k = 0; k < BATCH; ++k)
+            if (search->playout(candidate, random, game, moves, outcome))
+                outcomes.push_back(outcome);
+            else
+                break;
+        {
+            std::lock_guard<std::mutex> lock(search->mutex);
+            auto& replies = search->replies[candidate];
+            for (const auto& outcome: outcomes) {
+                search->stats[candidate].add(outcome.score, outcome.won);
+                if (outcome.reply != INVALID_POS)
+                    replies[outcome.reply].add(outcome.score,
+                                               outcome.won);
+            }
+        }
+        if (!search->isOver())
+            submit(search, candidate);
+    });
+}
+
+
+// Plays the candidate move and then random legal moves to the end of the
+// game. Returns false, abandoning the game, if the search is over first.
+bool Hinter::Search::playout(int candidate, Randomizer& random,
+                             Engine& game, Points& moves,
+                             Outcome& outcome) const {
+    game = root;
+    game.apply(this->moves[candidate], false);
+    outcome.reply = INVALID_POS;
+    while (game.state() == GameState::Playing) {
+        if (isOver())
+            return false;
+        moves.clear();
+        game.legalMoves(moves);
+        const auto move = moves[random.below(
+            static_cast<int>(moves.size()))];
+        if (outcome.reply == INVALID_POS)
+            outcome.reply = game.grid().index(move.x, move.y);
+        game.apply(move, false);
+    }
+    outcome.score = game.score();
+    outcome.won = game.state() == GameState::Won;
+    return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    Monte Carlo move analysis with no wx dependency. Random games are
+    played to the end from each legal group on every core, and each group
+    is ranked by the share of those games won and then by their mean final
+    score. A search runs in the background until its time budget is spent
+    or it is cancelled. The playouts also keep statistics for the move
+    after each first move, so once the player has moved, the statistics for
+    the position they reached start off the next search.
+*/
+
+#include "engine.hpp"
+#include "threadpool.hpp"
+
+#include <memory>
+#include <vector>
+
+
+struct Hint {
+    bool isValid() const { return point.isValid(); }
+
+    Point point; // The first tile of the group in row-major order
+    int size = 0;
+    long long playouts = 0;
+    double meanScore = 0;
+    double winRate = 0;
+};
+
+using Hints = std::vector<Hint>;
+
+
+class Hinter {
+public:
+    explicit Hinter(int threads=0);
+    ~Hinter();
+
+    void start(const Engine& engine, int budgetMs);
+    void cancel();
+    void played(const Point point, const Engine& engine);
+
+    bool isRunning() const;
+    Hints hints() const; // Best first
+    Hint best() const;
+    long long playouts() const;
+
+private:
+    struct Search;
+    struct Kept;
+
+    void submit(std::shared_ptr<Search> search, int candidate);
+
+    ThreadPool pool;
+    std::shared_ptr<Search> search; // The current or most recent search
+    std::unique_ptr<Kept> kept; // Its statistics for the move played
+};
@@ -6,28 +6,31 @@
 #include "helpwindow.hpp"
 #include "optionswindow.hpp"
 #include "mainwindow.hpp"
+#include "scoreswindow.hpp"
+#include "settings.hpp"
+#include "trace.hpp"
 #include "util.hpp"
 
 #include <wx/artprov.h>
-#include <wx/config.h>
-
-#include <memory>
+#include <wx/datetime.h>
+#include <wx/filedlg.h>
+#include <wx/filename.h>
+#include <wx/stdpaths.h>
 
 
 MainWindow::MainWindow()
         : wxFrame(nullptr, wxID_ANY, wxTheApp->GetAppName(),
-                  wxDefaultPosition, wxDefaultSize, FRAME_STYLE),
-          starting(true) {
+                  wxDefaultPosition, wxDefaultSize, FRAME_STYLE) {
     SetMinSize(wxSize(240, 300));
     SetTitle(wxTheApp->GetAppName());
     SetIcon(wxArtProvider::GetIcon(ICON_ID));
+    statusTimer.Bind(wxEVT_TIMER, [&](wxTimerEvent&) { SetStatusText(""); });
     makeWidgets();
     makeLayout();
     makeBindings();
     setPositionAndSize();
     startupTimer.Bind( // Only call after MainWindow is fully constructed
-        wxEVT_TIMER, [&](wxTimerEvent&) {
-            wxCommandEvent event; MainWindow::onNew(event); });
+        wxEVT_TIMER, [&](wxTimerEvent&) { onStart(); });
     startupTimer.StartOnce(50);
 }
 
@@ -36,8 +39,6 @@ void MainWindow::setTemporaryStatusMessage(const wxString& message,
                                            int timeoutMs) {
     statusTimer.Stop();
     SetStatusText(message);
-    statusTimer.Bind(wxEVT_TIMER,
-                     [&](wxTimerEvent&) { SetStatusText(""); });
     statusTimer.StartOnce(timeoutMs);
 }
 
@@ -58,6 +59,25 @@ void MainWindow::makeToolBar() {
         wxArtProvider::GetBitmap(wxART_NEW, wxART_TOOLBAR, size),
         "New game (n)");
     toolbar->AddSeparator();
+    toolbar->AddTool(
+        wxID_UNDO, "Undo",
+        wxArtProvider::GetBitmap(wxART_UNDO, wxART_TOOLBAR, size),
+        "Undo the last move (u)");
+    toolbar->AddTool(
+        wxID_REDO, "Redo",
+        wxArtProvider::GetBitmap(wxART_REDO, wxART_TOOLBAR, size),
+        "Redo the last undone move (r)");
+    toolbar->AddSeparator();
+    toolbar->AddTool(
+        HINT_TOOL_ID, "Hint",
+        wxArtProvider::GetBitmap(wxART_TIP, wxART_TOOLBAR, size),
+        "Highlight the best group to click (i)");
+    toolbar->AddSeparator();
+    toolbar->AddTool(
+        SCORES_TOOL_ID, "Scores",
+        wxArtProvider::GetBitmap(wxART_REPORT_VIEW, wxART_TOOLBAR, size),
+        "Statistics and best scores (l)");
+    toolbar->AddSeparator();
     toolbar->AddTool(
         wxID_PREFERENCES, "Options",
         wxArtProvider::GetBitmap(OPTIONS_ID, wxART_TOOLBAR, size),
@@ -92,7 +112,6 @@ void MainWindow::makeStatusBar() {
     const int widths[STATUS_FIELDS] = {-3, -1};
     statusBar->SetStatusWidths(STATUS_FIELDS, widths);
     showScores(0);
-    setTemporaryStatusMessage("Click a tile to play...");
 }
 
 
@@ -106,39 +125,37 @@ void MainWindow::makeLayout() {
 void MainWindow::makeBindings() {
     Bind(wxEVT_CHAR_HOOK, &MainWindow::onChar, this);
     Bind(wxEVT_TOOL, &MainWindow::onNew, this, wxID_NEW);
+    Bind(wxEVT_TOOL, [&](wxCommandEvent&) { board->undo(); }, wxID_UNDO);
+    Bind(wxEVT_TOOL, [&](wxCommandEvent&) { board->redo(); }, wxID_REDO);
+    Bind(wxEVT_TOOL, [&](wxCommandEvent&) { board->hint(); },
+         HINT_TOOL_ID);
+    Bind(wxEVT_TOOL, [&](wxCommandEvent&) {
+         onScores(this, board->scores()); }, SCORES_TOOL_ID);
     Bind(wxEVT_TOOL, [&](wxCommandEvent&) { onOptions(this); },
          wxID_PREFERENCES);
     Bind(wxEVT_TOOL, [&](wxCommandEvent&) { onAbout(this); }, wxID_ABOUT);
     Bind(wxEVT_TOOL, [&](wxCommandEvent&) { onHelp(this); }, wxID_HELP);
     Bind(wxEVT_TOOL, [&](wxCommandEvent&) { Close(true); }, wxID_EXIT);
     Bind(wxEVT_CLOSE_WINDOW, &MainWindow::onClose, this);
-    Bind(SCORE_EVENT, [&](wxCommandEvent& event) {
-         showScores(event.GetInt()); });
+    Bind(SCORE_EVENT, [&](wxCommandEvent&) { showScores(board->score()); });
     Bind(GAME_OVER_EVENT, &MainWindow::onGameOver, this);
+    Bind(HINT_EVENT, [&](wxCommandEvent& event) {
+         setTemporaryStatusMessage(event.GetString()); });
 }
 
 
 void MainWindow::setPositionAndSize() {
-    std::unique_ptr<wxConfig> config(new wxConfig(wxTheApp->GetAppName()));
-    int x;
-    config->Read(WINDOW_X, &x, -1);
-    int y;
-    config->Read(WINDOW_Y, &y, -1);
-    if (x > -1 && y > -1)
-        SetPosition(wxPoint(x, y));
-    int width;
-    config->Read(WINDOW_WIDTH, &width, 380);
-    int height;
-    config->Read(WINDOW_HEIGHT, &height, 440);
-    SetClientSize(width, height);
+    const auto& window = Settings::get().window();
+    if (window.x > -1 && window.y > -1)
+        SetPosition(window.GetPosition());
+    SetClientSize(window.GetSize());
 }
 
 
-void MainWindow::showScores(int score) {
-    std::unique_ptr<wxConfig> config(new wxConfig(wxTheApp->GetAppName()));
-    int highScore;
-    config->Read(HIGH_SCORE, &highScore, HIGH_SCORE_DEFAULT);
-    SetStatusText(humanize(score) + L" • " + humanize(highScore), 1);
+void MainWindow::showScores(Score score) {
+    TRACE_SCOPE("window/showScores");
+    SetStatusText(humanize(score) + L" • " +
+                  humanize(Settings::get().highScore()), 1);
 }
 
 
@@ -148,52 +165,136 @@ void MainWindow::onChar(wxKeyEvent& event) {
     else
         switch (event.GetUnicodeKey()) {
             case 'A': onAbout(this); break;
+            case 'E': onExport(); break;
             case 'H': onHelp(this); break;
+            case 'I': board->hint(); break;
+            case 'L': onScores(this, board->scores()); break;
             case 'N': { wxCommandEvent event; onNew(event); break; }
             case 'O': onOptions(this); break;
             case 'Q': Close(true); break;
+            case 'R': board->redo(); break;
+            case 'S': onPlaySeed(); break;
+            case 'T': onTrace(); break; // Deliberately not in the help
+            case 'U': board->undo(); break;
             default: event.Skip();
         }
 }
 
 
 void MainWindow::onClose(wxCloseEvent&) {
+    board->saveGame();
     saveConfig();
     Destroy();
 }
 
 
 void MainWindow::saveConfig() {
-    std::unique_ptr<wxConfig> config(new wxConfig(wxTheApp->GetAppName()));
-    const auto pos = GetPosition();
-    config->Write(WINDOW_X, pos.x);
-    config->Write(WINDOW_Y, pos.y);
-    const auto size = GetClientSize();
-    config->Write(WINDOW_WIDTH, size.GetWidth());
-    config->Write(WINDOW_HEIGHT, size.GetHeight());
+    auto& settings = Settings::get();
+    settings.setWindow(wxRect(GetPosition(), GetClientSize()));
+    settings.flush();
+}
+
+
+// Carries on with the game that was being played when last closed, if
+// there was one
+void MainWindow::onStart() {
+    if (board->resumeGame()) {
+        setTemporaryStatusMessage(wxString::Format(
+            L"Resumed seed %u • Click a tile to play...", board->seed()));
+        board->SetFocus();
+    }
+    else {
+        wxCommandEvent event;
+        onNew(event);
+    }
 }
 
 
 void MainWindow::onNew(wxCommandEvent&) {
-    if (starting)
-        starting = false;
-    else
-        SetStatusText("");
     board->newGame();
+    showSeed();
+    if (Settings::get().board().solvableOnly && !board->isProvenSolvable())
+        setTemporaryStatusMessage(wxString::Format(
+            L"Seed %u • No solvable deal was ready, so this one may not "
+            "be winnable", board->seed()));
+}
+
+
+// Deals the board for a given seed, e.g., one shared by another player
+void MainWindow::onPlaySeed() {
+    auto text = wxGetTextFromUser(
+        "Seed:", wxString::Format(L"Play Seed — %s",
+                                  wxTheApp->GetAppName()),
+        wxString::Format("%u", board->seed()), this);
+    if (text.IsEmpty()) // Cancelled
+        return;
+    unsigned long seed;
+    if (!text.Trim().Trim(false).ToULong(&seed) || seed > 0xFFFFFFFFUL) {
+        setTemporaryStatusMessage("Invalid seed: " + text);
+        return;
+    }
+    board->newGame(static_cast<unsigned>(seed));
+    showSeed();
+}
+
+
+// Saves an image of the whole board as it is shown, e.g., to attach to a
+// bug report along with the seed
+void MainWindow::onExport() {
+    wxFileDialog dialog(
+        this, wxString::Format(L"Export Board — %s", wxTheApp->GetAppName()),
+        wxStandardPaths::Get().GetDocumentsDir(),
+        wxString::Format("gravitate-%u.png", board->seed()),
+        "PNG images (*.png)|*.png", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+    if (dialog.ShowModal() != wxID_OK)
+        return;
+    const auto path = dialog.GetPath();
+    if (board->exportImage(path))
+        setTemporaryStatusMessage("Exported " + path);
+    else
+        setTemporaryStatusMessage("Failed to export " + path);
+}
+
+
+// For profiling on a user's machine: the first press starts tracing and
+// the next saves the trace in the user data directory
+void MainWindow::onTrace() {
+    if (!isTracing()) {
+        startTrace();
+        setTemporaryStatusMessage("Tracing... press t again to save");
+        return;
+    }
+    stopTrace();
+    wxFileName filename(wxStandardPaths::Get().GetUserDataDir(),
+                        wxDateTime::Now().Format("trace-%Y%m%d-%H%M%S.json"));
+    const auto path = filename.GetFullPath();
+    if (filename.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL) &&
+            writeTrace(path.ToStdString()))
+        setTemporaryStatusMessage("Saved trace " + path);
+    else
+        setTemporaryStatusMessage("Failed to save trace " + path);
+}
+
+
+// The same seed and options always deal the same board, even one that
+// is over as dealt
+void MainWindow::showSeed() {
+    setTemporaryStatusMessage(wxString::Format(
+        board->isGameOver() ? L"Seed %u • Lost as dealt • Click New..."
+                            : L"Seed %u • Click a tile to play...",
+        board->seed()));
     board->SetFocus();
 }
 
 
 void MainWindow::onGameOver(wxCommandEvent& event) {
-    const int score = event.GetInt();
-    std::unique_ptr<wxConfig> config(new wxConfig(wxTheApp->GetAppName()));
-    int highScore;
-    config->Read(HIGH_SCORE, &highScore, HIGH_SCORE_DEFAULT);
+    const auto score = board->score();
+    auto& settings = Settings::get();
     wxString text("Click New...");
     if (event.GetString() == WON) {
-        if (score > highScore) {
+        if (score > settings.highScore()) {
             text = "New Highscore! " + text;
-            config->Write(HIGH_SCORE, score);
+            settings.setHighScore(score);
         }
     }
     showScores(score);
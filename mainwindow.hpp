@@ -25,12 +25,17 @@ private:
     void makeLayout();
     void makeBindings();
     void setPositionAndSize();
-    void showScores(int);
+    void showScores(Score score);
+    void showSeed();
     void saveConfig();
 
     void onChar(wxKeyEvent&);
     void onClose(wxCloseEvent&);
+    void onStart();
     void onNew(wxCommandEvent&);
+    void onPlaySeed();
+    void onExport();
+    void onTrace();
     void onGameOver(wxCommandEvent&);
 
 #if wxVERSION_NUMBER < 3100
@@ -41,5 +46,4 @@ private:
     wxTimer statusTimer;
     wxPanel* panel;
     BoardWidget *board;
-    bool starting;
 };
@@ -0,0 +1,90 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include "movesequence.hpp"
+#include "trace.hpp"
+
+#include <cmath>
+
+
+MoveSequence::MoveSequence(ChangedCallback onChanged_, Callback onDone_)
+        : onChanged(onChanged_), onDone(onDone_), tiles(nullptr),
+          phase_(MovePhase::Idle), delayMs(0), handled_(0),
+          animator(onChanged_) {
+    timer.Bind(wxEVT_TIMER, &MoveSequence::onTimer, this);
+}
+
+
+// Shows move on tiles, which must be as they were before the move
+void MoveSequence::start(Grid* tiles_, const MoveResult& move,
+                         int delayMs_) {
+    stop();
+    tiles = tiles_;
+    move_ = move;
+    delayMs = delayMs_;
+    dimAdjoining();
+}
+
+
+// Since the engine has already finished the move, any animation can be
+// skipped to its end (which calls onDone)
+void MoveSequence::finishAnimation() {
+    if (animator.isRunning())
+        animator.finish();
+}
+
+
+// Abandons the move without calling onDone
+void MoveSequence::stop() {
+    timer.Stop();
+    animator.stop();
+    phase_ = MovePhase::Idle;
+}
+
+
+// Each phase's delay ends here: this is the timer's only handler
+void MoveSequence::onTimer(wxTimerEvent&) {
+    TRACE_SCOPE("move/timer");
+    ++handled_;
+    switch (phase_) {
+        case MovePhase::Dimming: deleteAdjoining(); break;
+        case MovePhase::Deleting: closeTilesUp(); break;
+        default: break;
+    }
+}
+
+
+void MoveSequence::dimAdjoining() {
+    TRACE_SCOPE("move/dimTiles");
+    phase_ = MovePhase::Dimming;
+    for (const auto& point: move_.removed) {
+        tiles->at(point.x, point.y) |= DIMMED;
+        onChanged(point);
+    }
+    timer.StartOnce(delayMs);
+}
+
+
+void MoveSequence::deleteAdjoining() {
+    TRACE_SCOPE("move/deleteTiles");
+    phase_ = MovePhase::Deleting;
+    for (const auto& point: move_.removed) {
+        tiles->at(point.x, point.y) = NO_COLOR;
+        onChanged(point);
+    }
+    timer.StartOnce(delayMs);
+}
+
+
+void MoveSequence::closeTilesUp() {
+    phase_ = MovePhase::ClosingUp;
+    const int stepMs = static_cast<int>(std::round(delayMs / 7));
+    animator.start(tiles, move_.moves, stepMs, [&]() { finishMove(); });
+}
+
+
+void MoveSequence::finishMove() {
+    phase_ = MovePhase::Idle;
+    if (onDone)
+        onDone();
+}
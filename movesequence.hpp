@@ -0,0 +1,58 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    Shows a move that the engine has already played on a view's Grid: the
+    removed group is dimmed, then deleted, then the tiles close up (see
+    Animator), and then onDone is called. Each phase's delay is one
+    single-shot wxTimer whose only handler is bound at construction, so a
+    move costs the same however many moves came before it. No window is
+    needed, so the bench can step thousands of moves with notify().
+*/
+
+#include "animator.hpp"
+
+#include <wx/wxprec.h>
+#ifndef WX_PRECOMP
+    #include <wx/wx.h>
+#endif
+
+
+// A move goes Dimming → Deleting → ClosingUp → Idle
+enum class MovePhase { Idle, Dimming, Deleting, ClosingUp };
+
+
+class MoveSequence {
+public:
+    using Callback = Animator::Callback;
+    using ChangedCallback = Animator::ChangedCallback;
+
+    MoveSequence(ChangedCallback onChanged, Callback onDone);
+
+    void start(Grid* tiles, const MoveResult& move, int delayMs);
+    void finishAnimation();
+    void stop();
+    void notify() { timer.Notify(); } // As if the phase's delay had ended
+    bool isRunning() const { return phase_ != MovePhase::Idle; }
+    MovePhase phase() const { return phase_; }
+    const MoveResult& move() const { return move_; }
+    long handled() const { return handled_; }
+
+private:
+    void onTimer(wxTimerEvent&);
+    void dimAdjoining();
+    void deleteAdjoining();
+    void closeTilesUp();
+    void finishMove();
+
+    ChangedCallback onChanged;
+    Callback onDone;
+    Grid* tiles;
+    MoveResult move_;
+    MovePhase phase_;
+    int delayMs;
+    long handled_; // Timer events handled; a move's are exactly two
+    wxTimer timer;
+    Animator animator;
+};
@@ -3,14 +3,14 @@
 
 #include "boardutil.hpp"
 #include "constants.hpp"
+#include "dealer.hpp"
 #include "optionswindow.hpp"
+#include "settings.hpp"
 
 #include <wx/artprov.h>
-#include <wx/config.h>
 #include <wx/gbsizer.h>
 
 #include <cmath>
-#include <memory>
 
 
 void onOptions(MainWindow *parent) {
@@ -35,42 +35,54 @@ OptionsWindow::OptionsWindow(wxWindow* parent)
 
 void OptionsWindow::makeWidgets() {
     const auto style = wxSP_ARROW_KEYS | wxALIGN_RIGHT;
-    std::unique_ptr<wxConfig> config(new wxConfig(wxTheApp->GetAppName()));
+    const auto& options = Settings::get().board();
     panel = new wxPanel(this);
     columnsLabel = new wxStaticText(panel, wxID_ANY, "Co&lumns");
-    int n;
-    config->Read(COLUMNS, &n, COLUMNS_DEFAULT);
     columnsSpinCtrl = new wxSpinCtrl(
         panel, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize,
-        style, 5, 30, n);
+        style, BOARD_SIZE_MIN, BOARD_SIZE_MAX, options.columns);
     columnsSpinCtrl->SetToolTip(wxString::Format(
-        "How many columns of tiles to use [default %d]", COLUMNS_DEFAULT));
+        "How many columns of tiles to use (large boards can be zoomed and "
+        "panned) [default %d]", COLUMNS_DEFAULT));
     rowsLabel = new wxStaticText(panel, wxID_ANY, "&Rows");
-    config->Read(ROWS, &n, ROWS_DEFAULT);
     rowsSpinCtrl = new wxSpinCtrl(
         panel, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize,
-        style, 5, 30, n);
+        style, BOARD_SIZE_MIN, BOARD_SIZE_MAX, options.rows);
     rowsSpinCtrl->SetToolTip(wxString::Format(
-        "How many rows of tiles to use [default %d]", ROWS_DEFAULT));
+        "How many rows of tiles to use (large boards can be zoomed and "
+        "panned) [default %d]", ROWS_DEFAULT));
     maxColorsLabel = new wxStaticText(panel, wxID_ANY, "&Max. Colors");
-    config->Read(MAX_COLORS, &n, MAX_COLORS_DEFAULT);
     maxColorsSpinCtrl = new wxSpinCtrl(
         panel, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize,
-        style, 2, colorCount(), n);
+        style, 2, PALETTE_SIZE, options.maxColors);
     maxColorsSpinCtrl->SetToolTip(wxString::Format(
         "How many colors to use [default %d]", MAX_COLORS_DEFAULT));
     delayMsLabel = new wxStaticText(panel, wxID_ANY, "&Delay (ms)");
-    config->Read(DELAY_MS, &n, DELAY_MS_DEFAULT);
     delayMsSpinCtrl = new wxSpinCtrl(
         panel, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize,
-        style, 0, 1000, n);
+        style, 0, 1000, options.delayMs);
     delayMsSpinCtrl->SetToolTip(wxString::Format(
         "How long to show tile movement in milliseconds (1/1000ths second) "
         "[default %d]", DELAY_MS_DEFAULT));
+    hintMsLabel = new wxStaticText(panel, wxID_ANY, "&Hint Time (ms)");
+    hintMsSpinCtrl = new wxSpinCtrl(
+        panel, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize,
+        style, 10, 10000, options.hintMs);
+    hintMsSpinCtrl->SetToolTip(wxString::Format(
+        "How long to spend looking for a hint in milliseconds (1/1000ths "
+        "second) [default %d]", HINT_MS_DEFAULT));
+    solvableOnlyCheckBox = new wxCheckBox(panel, wxID_ANY,
+                                          "&Solvable Deals Only");
+    solvableOnlyCheckBox->SetValue(options.solvableOnly);
+    solvableOnlyCheckBox->SetToolTip(wxString::Format(
+        "Only deal boards that are proven winnable (only for boards of up "
+        "to %d tiles; they are found in the background so New stays "
+        "instant) [default off]", DEAL_CELLS_MAX));
     okButton = new wxButton(panel, wxID_OK, "&OK");
     okButton->SetDefault();
-    okButton->SetToolTip("Confirm option choices: these will take effect "
-                         "when you click New for a new game");
+    okButton->SetToolTip("Confirm option choices: the timings take effect "
+                         "at once and the rest when you click New for a "
+                         "new game");
     padLabel = new wxStaticText(panel, wxID_ANY, " ");
     cancelButton = new wxButton(panel, wxID_CANCEL, "&Cancel");
     cancelButton->SetToolTip("Leave the option choices unchanged");
@@ -92,11 +104,16 @@ void OptionsWindow::makeLayout() {
     grid->Add(delayMsLabel, wxGBPosition(3, 0), wxDefaultSpan, flag, PAD);
     grid->Add(delayMsSpinCtrl, wxGBPosition(3, 1), wxDefaultSpan, flagX,
               PAD);
+    grid->Add(hintMsLabel, wxGBPosition(4, 0), wxDefaultSpan, flag, PAD);
+    grid->Add(hintMsSpinCtrl, wxGBPosition(4, 1), wxDefaultSpan, flagX,
+              PAD);
+    grid->Add(solvableOnlyCheckBox, wxGBPosition(5, 0), wxGBSpan(1, 2),
+              flag, PAD);
     auto buttonSizer = new wxStdDialogButtonSizer;
     buttonSizer->AddButton(okButton);
     buttonSizer->AddButton(cancelButton);
     buttonSizer->Realize();
-    grid->Add(buttonSizer, wxGBPosition(4, 0), wxGBSpan(1, 2), flag,
+    grid->Add(buttonSizer, wxGBPosition(6, 0), wxGBSpan(1, 2), flag,
               PAD * 2);
     panel->SetSizerAndFit(grid);
     auto mainSizer = new wxBoxSizer(wxVERTICAL);
@@ -106,10 +123,13 @@ void OptionsWindow::makeLayout() {
 
 
 void OptionsWindow::onOk(wxCommandEvent&) {
-    std::unique_ptr<wxConfig> config(new wxConfig(wxTheApp->GetAppName()));
-    config->Write(COLUMNS, columnsSpinCtrl->GetValue());
-    config->Write(ROWS, rowsSpinCtrl->GetValue());
-    config->Write(MAX_COLORS, maxColorsSpinCtrl->GetValue());
-    config->Write(DELAY_MS, delayMsSpinCtrl->GetValue());
+    BoardOptions options;
+    options.columns = columnsSpinCtrl->GetValue();
+    options.rows = rowsSpinCtrl->GetValue();
+    options.maxColors = maxColorsSpinCtrl->GetValue();
+    options.delayMs = delayMsSpinCtrl->GetValue();
+    options.hintMs = hintMsSpinCtrl->GetValue();
+    options.solvableOnly = solvableOnlyCheckBox->GetValue();
+    Settings::get().setBoard(options);
     EndModal(wxID_OK);
 }
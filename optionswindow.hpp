@@ -32,6 +32,9 @@ private:
     wxSpinCtrl* maxColorsSpinCtrl;
     wxStaticText* delayMsLabel;
     wxSpinCtrl* delayMsSpinCtrl;
+    wxStaticText* hintMsLabel;
+    wxSpinCtrl* hintMsSpinCtrl;
+    wxCheckBox* solvableOnlyCheckBox;
     wxButton* okButton;
     wxStaticText* padLabel;
     wxButton* cancelButton;
@@ -0,0 +1,34 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    The tile colors as a fixed table addressed by index. The engine picks
+    which entries a game uses and only ever deals in indexes; views turn
+    the indexes into real colors once per game.
+*/
+
+#include <cstdint>
+#include <vector>
+
+
+struct PaletteColor {
+    std::uint32_t dark;
+    std::uint32_t light;
+};
+
+
+const PaletteColor PALETTE[]{
+    {0xFF800000, 0xFFF99999},
+    {0xFF008000, 0xFF99F999},
+    {0xFF808000, 0xFFF9F999},
+    {0xFF000080, 0xFF9999F9},
+    {0xFF800080, 0xFFF999F9},
+    {0xFF008080, 0xFF99F9F9},
+    {0xFF808080, 0xFFF9F9F9},
+};
+
+const int PALETTE_SIZE = sizeof(PALETTE) / sizeof(PALETTE[0]);
+
+
+using PaletteIndexes = std::vector<int>; // Color c is at [c - 1]
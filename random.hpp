@@ -0,0 +1,98 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    A small, fast generator (xoshiro256**) whose sequences are fully
+    specified, so that the same seed deals the same board and settles it
+    the same way with every compiler and standard library. The standard
+    engines' and distributions' sequences are implementation-defined, so
+    the game uses below(), between(), and shuffle() rather than
+    std::uniform_int_distribution and std::shuffle.
+*/
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+
+class Randomizer {
+public:
+    using result_type = std::uint64_t;
+    using State = std::array<std::uint64_t, 4>;
+
+    explicit Randomizer(std::uint64_t seed=0) { this->seed(seed); }
+
+    // The state is filled in by splitmix64 so that any seed, even 0, gives
+    // a good starting state
+    void seed(std::uint64_t seed) {
+        for (auto& word: words) {
+            std::uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    // For saving and resuming a generator; an all-zero state (which would
+    // only ever produce zeros) reseeds instead
+    State state() const { return words; }
+    void setState(const State& state) {
+        if (state == State{})
+            seed(0);
+        else
+            words = state;
+    }
+
+    result_type operator()() {
+        const std::uint64_t result = rotl(words[1] * 5, 7) * 9;
+        const std::uint64_t t = words[1] << 17;
+        words[2] ^= words[0];
+        words[3] ^= words[1];
+        words[1] ^= words[2];
+        words[0] ^= words[3];
+        words[2] ^= t;
+        words[3] = rotl(words[3], 45);
+        return result;
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    // Returns a uniformly distributed int in [0, n) for n > 0 using
+    // Lemire's multiply-and-reject method, which rarely needs a division
+    int below(int n) {
+        const auto bound = static_cast<std::uint32_t>(n);
+        auto m = static_cast<std::uint64_t>(next32()) * bound;
+        auto low = static_cast<std::uint32_t>(m);
+        if (low < bound) {
+            const std::uint32_t threshold = -bound % bound;
+            while (low < threshold) {
+                m = static_cast<std::uint64_t>(next32()) * bound;
+                low = static_cast<std::uint32_t>(m);
+            }
+        }
+        return static_cast<int>(m >> 32);
+    }
+
+    // Returns a uniformly distributed int in [low, high]
+    int between(int low, int high) { return low + below(high - low + 1); }
+
+    // Fisher-Yates; Iter must be a random access iterator
+    template<typename Iter>
+    void shuffle(Iter first, Iter last) {
+        for (auto n = std::distance(first, last); n > 1; --n)
+            std::swap(first[n - 1], first[below(static_cast<int>(n))]);
+    }
+
+private:
+    static std::uint64_t rotl(std::uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+    std::uint32_t next32() {
+        return static_cast<std::uint32_t>((*this)() >> 32);
+    }
+
+    State words;
+};
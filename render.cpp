@@ -0,0 +1,187 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    Renders games with no window: scons gravitate-render &&
+        ./gravitate-render [options] file.grvr|file.grvs
+    A snapshot is rendered as it stands and a replay at its end, and with
+    --every N after every N moves too, each as PREFIX-MOVE.png (PREFIX is
+    the file's name less its extension unless --output is given).
+    --frames N instead times N full repaints of the final board at --size
+    and prints the frames per second as CSV. wxWidgets needs a display on
+    some platforms, but a virtual one (e.g., xvfb-run) will do.
+*/
+
+#include "boardrenderer.hpp"
+#include "replay.hpp"
+#include "snapshot.hpp"
+
+#include <wx/dcmemory.h>
+#include <wx/filename.h>
+#include <wx/init.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* USAGE =
+    "usage: gravitate-render [--tile PIXELS] [--every N] [--output PREFIX]\n"
+    "    [--frames N [--size WxH]] file.grvr|file.grvs\n";
+
+struct Options {
+    int tile = 24; // Pixels a side for images
+    int every = 0; // Also render after every this many replay moves
+    std::string output; // Image filename prefix
+    int frames = 0; // If nonzero, time this many repaints instead
+    wxSize size{1280, 960}; // Of the frames timed
+    std::string filename;
+};
+
+
+bool parse(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg(argv[i]);
+        if (i + 1 == argc) {
+            options.filename = arg;
+            break;
+        }
+        const char* value = argv[++i];
+        if (arg == "--tile")
+            options.tile = std::atoi(value);
+        else if (arg == "--every")
+            options.every = std::atoi(value);
+        else if (arg == "--output")
+            options.output = value;
+        else if (arg == "--frames")
+            options.frames = std::atoi(value);
+        else if (arg == "--size") {
+            if (std::sscanf(value, "%dx%d", &options.size.x,
+                            &options.size.y) != 2)
+                return false;
+        }
+        else
+            return false;
+    }
+    if (options.output.empty()) {
+        const wxFileName filename(options.filename);
+        options.output = (filename.GetPathWithSep() +
+                          filename.GetName()).ToStdString();
+    }
+    return !options.filename.empty() && options.tile > 0 &&
+           options.every >= 0 && options.frames >= 0 &&
+           options.size.x > 0 && options.size.y > 0;
+}
+
+
+class Renderer {
+public:
+    explicit Renderer(const Options& options_) : options(options_) {}
+
+    void setPalette(const PaletteIndexes& indexes) {
+        renderer.setPalette(indexes);
+    }
+    bool image(const Engine& engine);
+    void frames(const Engine& engine);
+
+private:
+    const Options& options;
+    BoardRenderer renderer;
+};
+
+
+bool Renderer::image(const Engine& engine) {
+    auto view = wholeBoardView(engine.grid(), options.tile);
+    view.gameOver = engine.state() != GameState::Playing;
+    view.userWon = engine.state() == GameState::Won;
+    const auto filename = wxString::Format(
+        "%s-%04d.png", options.output,
+        static_cast<int>(engine.history().size()));
+    if (savePng(renderer.render(engine.grid(), view), filename))
+        return true;
+    std::fprintf(stderr, "failed to write %s\n",
+                 filename.ToStdString().c_str());
+    return false;
+}
+
+
+// The first frame renders the tiles into the cache, so it isn't timed
+void Renderer::frames(const Engine& engine) {
+    BoardView view;
+    view.size = options.size;
+    const auto size = fitTileSize(view.size, engine.columns(),
+                                  engine.rows());
+    view.tileWidth = static_cast<int>(size.width);
+    view.tileHeight = static_cast<int>(size.height);
+    view.gameOver = engine.state() != GameState::Playing;
+    view.userWon = engine.state() == GameState::Won;
+    wxBitmap bitmap(view.size.x, view.size.y);
+    wxMemoryDC dc(bitmap);
+    renderer.paint(dc, engine.grid(), view);
+    const auto start = Clock::now();
+    for (int i = 0; i < options.frames; ++i)
+        renderer.paint(dc, engine.grid(), view);
+    const double seconds = std::chrono::duration<double>(
+        Clock::now() - start).count();
+    std::printf("columns,rows,width,height,tile,frames,seconds,"
+                "frames_per_second\n");
+    std::printf("%d,%d,%d,%d,%d,%d,%.3f,%.1f\n", engine.columns(),
+                engine.rows(), view.size.x, view.size.y, view.tileWidth,
+                options.frames, seconds, options.frames / seconds);
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[]) {
+    wxInitializer initializer;
+    if (!initializer.IsOk()) {
+        std::fprintf(stderr, "failed to initialize wxWidgets\n");
+        return 1;
+    }
+    Options options;
+    if (!parse(argc, argv, options)) {
+        std::fprintf(stderr, "%s", USAGE);
+        return 2;
+    }
+    Renderer renderer(options);
+    Engine engine;
+    Point focus;
+    if (loadSnapshot(options.filename, engine, focus)) {
+        renderer.setPalette(engine.palette());
+        if (options.frames)
+            renderer.frames(engine);
+        else if (!renderer.image(engine))
+            return 1;
+        return 0;
+    }
+    Replay replay;
+    if (!loadReplay(options.filename, replay)) {
+        std::fprintf(stderr, "%s isn't a valid replay or snapshot\n",
+                     options.filename.c_str());
+        return 1;
+    }
+    engine.setUndoable(false);
+    engine.newGame(replay.columns, replay.rows, replay.maxColors,
+                   replay.seed);
+    renderer.setPalette(engine.palette());
+    for (size_t i = 0; i < replay.moves.size(); ++i) {
+        if (options.every && !options.frames && i % options.every == 0 &&
+                !renderer.image(engine))
+            return 1;
+        if (!engine.apply(replay.moves[i], false).isValid()) {
+            std::fprintf(stderr, "%s has an illegal move\n",
+                         options.filename.c_str());
+            return 1;
+        }
+    }
+    if (options.frames)
+        renderer.frames(engine);
+    else if (!renderer.image(engine))
+        return 1;
+}
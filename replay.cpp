@@ -0,0 +1,158 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include "replay.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+
+namespace {
+
+const char MAGIC[] = "GRVR";
+const int MAGIC_SIZE = 4;
+const int MAX_VARINT_BYTES = 10;
+const int MAX_MOVE_BYTES = 4; // A move's varint, since cells < 2^28
+const std::streamoff FILE_SIZE_MAX = 64 + std::streamoff(MAX_MOVE_BYTES) *
+    BOARD_SIZE_MAX * BOARD_SIZE_MAX;
+
+
+void putVarint(Bytes& bytes, std::uint64_t value) {
+    while (value >= 0x80) {
+        bytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back(static_cast<std::uint8_t>(value));
+}
+
+
+// Reads a varint at pos and advances pos past it; returns false if the
+// bytes run out or the varint is too long
+bool getVarint(const Bytes& bytes, size_t& pos, std::uint64_t& value) {
+    value = 0;
+    for (int i = 0; i < MAX_VARINT_BYTES && pos < bytes.size(); ++i) {
+        const auto byte = bytes[pos++];
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << (7 * i);
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+
+bool getInt(const Bytes& bytes, size_t& pos, int& value, int maximum) {
+    std::uint64_t n;
+    if (!getVarint(bytes, pos, n) || n > static_cast<std::uint64_t>(maximum))
+        return false;
+    value = static_cast<int>(n);
+    return true;
+}
+
+} // namespace
+
+
+Replay makeReplay(const Engine& engine) {
+    Replay replay;
+    replay.columns = engine.columns();
+    replay.rows = engine.rows();
+    replay.maxColors = engine.maxColors();
+    replay.seed = engine.seed();
+    replay.moves = engine.history();
+    replay.score = engine.score();
+    replay.state = engine.state();
+    return replay;
+}
+
+
+Bytes encodeReplay(const Replay& replay) {
+    Bytes bytes(MAGIC, MAGIC + MAGIC_SIZE);
+    bytes.push_back(REPLAY_VERSION);
+    putVarint(bytes, replay.columns);
+    putVarint(bytes, replay.rows);
+    putVarint(bytes, replay.maxColors);
+    putVarint(bytes, replay.seed);
+    putVarint(bytes, replay.moves.size());
+    for (const auto& move: replay.moves)
+        putVarint(bytes, static_cast<std::uint64_t>(move.y) *
+                  replay.columns + move.x);
+    putVarint(bytes, static_cast<std::uint64_t>(replay.score));
+    bytes.push_back(static_cast<std::uint8_t>(replay.state));
+    return bytes;
+}
+
+
+bool decodeReplay(const Bytes& bytes, Replay& replay) {
+    if (bytes.size() < MAGIC_SIZE + 1 ||
+            !std::equal(MAGIC, MAGIC + MAGIC_SIZE, bytes.cbegin()) ||
+            bytes[MAGIC_SIZE] != REPLAY_VERSION)
+        return false;
+    size_t pos = MAGIC_SIZE + 1;
+    Replay result;
+    int count;
+    if (!getInt(bytes, pos, result.columns, BOARD_SIZE_MAX) ||
+            !getInt(bytes, pos, result.rows, BOARD_SIZE_MAX) ||
+            !getInt(bytes, pos, result.maxColors, PALETTE_SIZE) ||
+            result.columns < 1 || result.rows < 1 ||
+            result.maxColors < 2)
+        return false;
+    std::uint64_t n;
+    if (!getVarint(bytes, pos, n) || n > 0xFFFFFFFFu)
+        return false;
+    result.seed = static_cast<unsigned>(n);
+    const int cells = result.columns * result.rows;
+    // Every move takes at least a byte, so a count that the bytes left
+    // can't hold is rejected before anything is allocated for it
+    if (!getInt(bytes, pos, count, cells) ||
+            static_cast<size_t>(count) > bytes.size() - pos)
+        return false;
+    result.moves.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        int cell;
+        if (!getInt(bytes, pos, cell, cells - 1))
+            return false;
+        result.moves.push_back(Point(cell % result.columns,
+                                     cell / result.columns));
+    }
+    if (!getVarint(bytes, pos, n) || pos + 1 != bytes.size() ||
+            bytes[pos] > static_cast<std::uint8_t>(GameState::Lost))
+        return false;
+    result.score = static_cast<Score>(n);
+    result.state = static_cast<GameState>(bytes[pos]);
+    replay = result;
+    return true;
+}
+
+
+bool saveReplay(const std::string& filename, const Replay& replay) {
+    const auto bytes = encodeReplay(replay);
+    std::ofstream file(filename, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(bytes.data()),
+               static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(file);
+}
+
+
+// A file too big to be a replay of the biggest board isn't read at all
+bool loadReplay(const std::string& filename, Replay& replay) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+    const std::streamoff size = file.tellg();
+    if (size < 0 || size > FILE_SIZE_MAX || !file.seekg(0))
+        return false;
+    Bytes bytes(static_cast<size_t>(size));
+    if (!file.read(reinterpret_cast<char*>(bytes.data()), size))
+        return false;
+    return decodeReplay(bytes, replay);
+}
+
+
+bool playReplay(const Replay& replay, Engine& engine) {
+    engine.newGame(replay.columns, replay.rows, replay.maxColors,
+                   replay.seed);
+    for (const auto& move: replay.moves)
+        if (!engine.apply(move, false).isValid())
+            return false;
+    return engine.score() == replay.score &&
+        engine.state() == replay.state;
+}
@@ -0,0 +1,49 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    A game is fully determined by its size, color count, deal seed and
+    clicks, since the settle pass is seeded from the board. A replay
+    records just these, plus the final score and state so that
+    re-simulating it can be checked. The binary format is:
+        "GRVR" version:u8 columns rows maxColors seed moveCount
+        move... score state:u8
+    where every field after the version except the state is an unsigned
+    LEB128 varint and each move is the clicked cell's row-major index.
+*/
+
+#include "engine.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+const std::uint8_t REPLAY_VERSION = 2; // 2: dealt by random.hpp
+
+
+struct Replay {
+    int columns = 0;
+    int rows = 0;
+    int maxColors = 0;
+    unsigned seed = 0;
+    Points moves;
+    Score score = 0;
+    GameState state = GameState::Playing;
+};
+
+using Bytes = std::vector<std::uint8_t>;
+
+
+Replay makeReplay(const Engine& engine);
+
+Bytes encodeReplay(const Replay& replay);
+bool decodeReplay(const Bytes& bytes, Replay& replay);
+
+bool saveReplay(const std::string& filename, const Replay& replay);
+bool loadReplay(const std::string& filename, Replay& replay);
+
+// Deals the replay's board and applies its moves; returns false if a move
+// is illegal or the outcome differs from the one recorded
+bool playReplay(const Replay& replay, Engine& engine);
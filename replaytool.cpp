@@ -0,0 +1,100 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    Re-simulates replays: scons gravitate-replay && ./gravitate-replay
+        [--check] file.grvr [file.grvr ...]
+    Each replay is printed as a CSV line; the exit status is 1 if any
+    replay can't be read or doesn't reach its recorded outcome. With
+    --check, the engine's incrementally kept counts are also compared
+    with whole-board scans after every move, and any difference fails
+    the replay.
+*/
+
+#include "replay.hpp"
+#include "scan.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* stateName(GameState state) {
+    switch (state) {
+        case GameState::Won: return "won";
+        case GameState::Lost: return "lost";
+        default: return "playing";
+    }
+}
+
+
+// Returns true if the engine's counts match what scanning its board finds
+bool isConsistent(const Engine& engine) {
+    const auto& tiles = engine.grid();
+    const auto histogram = colorHistogram(tiles);
+    for (int color = 1; color <= engine.maxColors(); ++color)
+        if (histogram[color] != engine.colorCount(color))
+            return false;
+    Points moves;
+    engine.legalMoves(moves);
+    int legalCells = 0;
+    for (const auto& move: moves)
+        legalCells += engine.groupSize(move);
+    return hasLegalCell(tiles) == (engine.legalMoveCount() > 0) &&
+        legalCellCount(tiles) == legalCells;
+}
+
+
+// Like playReplay() but checks the engine before and after every move
+bool checkReplay(const Replay& replay, Engine& engine) {
+    engine.newGame(replay.columns, replay.rows, replay.maxColors,
+                   replay.seed);
+    if (!isConsistent(engine))
+        return false;
+    for (const auto& move: replay.moves)
+        if (!engine.apply(move, false).isValid() || !isConsistent(engine))
+            return false;
+    return engine.score() == replay.score &&
+        engine.state() == replay.state;
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[]) {
+    const bool check = argc > 1 && std::strcmp(argv[1], "--check") == 0;
+    const int first = check ? 2 : 1;
+    if (argc <= first) {
+        std::fprintf(stderr, "usage: gravitate-replay [--check] file.grvr "
+                     "[file.grvr ...]\n");
+        return 2;
+    }
+    int status = 0;
+    Engine engine;
+    std::printf("file,columns,rows,colors,seed,moves,score,state,ok,us\n");
+    for (int i = first; i < argc; ++i) {
+        Replay replay;
+        if (!loadReplay(argv[i], replay)) {
+            std::fprintf(stderr, "%s: not a valid replay\n", argv[i]);
+            status = 1;
+            continue;
+        }
+        const auto start = Clock::now();
+        const bool ok = check ? checkReplay(replay, engine)
+                              : playReplay(replay, engine);
+        const std::chrono::duration<double, std::micro> elapsed =
+            Clock::now() - start;
+        if (!ok)
+            status = 1;
+        std::printf("%s,%d,%d,%d,%u,%zu,%lld,%s,%d,%.1f\n", argv[i],
+                    replay.columns, replay.rows, replay.maxColors,
+                    replay.seed, replay.moves.size(),
+                    static_cast<long long>(replay.score),
+                    stateName(replay.state), ok, elapsed.count());
+    }
+    return status;
+}
@@ -0,0 +1,368 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include "scan.hpp"
+
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+    #define SCAN_X86
+    #include <immintrin.h>
+#endif
+
+
+namespace {
+
+// Counts a row's legal cells, or if first is true, stops at the first
+// one; up and down are nullptr at the top and bottom of the board
+using RowScan = int (*)(const Cell* row, const Cell* up, const Cell* down,
+                        int columns, bool first);
+
+
+inline bool isLegalAt(const Cell* row, const Cell* up, const Cell* down,
+                      int x, int columns) {
+    const int color = row[x] & COLOR_MASK;
+    return color != NO_COLOR &&
+        ((x > 0 && (row[x - 1] & COLOR_MASK) == color) ||
+         (x + 1 < columns && (row[x + 1] & COLOR_MASK) == color) ||
+         (up && (up[x] & COLOR_MASK) == color) ||
+         (down && (down[x] & COLOR_MASK) == color));
+}
+
+
+// Only does the cells in [from, to)
+int scalarCells(const Cell* row, const Cell* up, const Cell* down,
+                int from, int to, int columns, bool first) {
+    int count = 0;
+    for (int x = from; x < to; ++x)
+        if (isLegalAt(row, up, down, x, columns)) {
+            ++count;
+            if (first)
+                break;
+        }
+    return count;
+}
+
+
+int scalarRow(const Cell* row, const Cell* up, const Cell* down,
+              int columns, bool first) {
+    return scalarCells(row, up, down, 0, columns, columns, first);
+}
+
+
+// Uses four counts so that runs of one color don't make every increment
+// wait for the one before
+ColorCounts scalarHistogram(const Cell* cells, int size) {
+    int counts[4][MAX_COLOR_INDEX + 1]{};
+    int i = 0;
+    for (; i + 4 <= size; i += 4) {
+        ++counts[0][cells[i] & COLOR_MASK];
+        ++counts[1][cells[i + 1] & COLOR_MASK];
+        ++counts[2][cells[i + 2] & COLOR_MASK];
+        ++counts[3][cells[i + 3] & COLOR_MASK];
+    }
+    for (; i < size; ++i)
+        ++counts[0][cells[i] & COLOR_MASK];
+    ColorCounts histogram;
+    for (int color = 0; color <= MAX_COLOR_INDEX; ++color)
+        histogram[color] = counts[0][color] + counts[1][color] +
+                           counts[2][color] + counts[3][color];
+    return histogram;
+}
+
+
+#ifdef SCAN_X86
+__attribute__((target("sse2")))
+inline __m128i sse2Load(const Cell* cells, __m128i mask) {
+    return _mm_and_si128(_mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(cells)), mask);
+}
+
+
+__attribute__((target("avx2")))
+inline __m256i avx2Load(const Cell* cells, __m256i mask) {
+    return _mm256_and_si256(_mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(cells)), mask);
+}
+
+
+// The first and last cells of a row have only one neighbour in it, so
+// they, and any cells left over, are done by the scalar code
+__attribute__((target("sse2")))
+int sse2Row(const Cell* row, const Cell* up, const Cell* down, int columns,
+            bool first) {
+    const int LANES = 16;
+    const __m128i mask = _mm_set1_epi8(COLOR_MASK);
+    const __m128i zero = _mm_setzero_si128();
+    int count = scalarCells(row, up, down, 0, 1, columns, first);
+    if (first && count)
+        return count;
+    int x = 1;
+    for (; x + LANES < columns; x += LANES) {
+        const __m128i color = sse2Load(row + x, mask);
+        __m128i same = _mm_or_si128(
+            _mm_cmpeq_epi8(color, sse2Load(row + x - 1, mask)),
+            _mm_cmpeq_epi8(color, sse2Load(row + x + 1, mask)));
+        if (up)
+            same = _mm_or_si128(
+                same, _mm_cmpeq_epi8(color, sse2Load(up + x, mask)));
+        if (down)
+            same = _mm_or_si128(
+                same, _mm_cmpeq_epi8(color, sse2Load(down + x, mask)));
+        const unsigned legal = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_andnot_si128(_mm_cmpeq_epi8(color, zero), same)));
+        if (legal) {
+            if (first)
+                return 1;
+            count += __builtin_popcount(legal);
+        }
+    }
+    return count + scalarCells(row, up, down, x, columns, columns, first);
+}
+
+
+__attribute__((target("avx2")))
+int avx2Row(const Cell* row, const Cell* up, const Cell* down, int columns,
+            bool first) {
+    const int LANES = 32;
+    const __m256i mask = _mm256_set1_epi8(COLOR_MASK);
+    const __m256i zero = _mm256_setzero_si256();
+    int count = scalarCells(row, up, down, 0, 1, columns, first);
+    if (first && count)
+        return count;
+    int x = 1;
+    for (; x + LANES < columns; x += LANES) {
+        const __m256i color = avx2Load(row + x, mask);
+        __m256i same = _mm256_or_si256(
+            _mm256_cmpeq_epi8(color, avx2Load(row + x - 1, mask)),
+            _mm256_cmpeq_epi8(color, avx2Load(row + x + 1, mask)));
+        if (up)
+            same = _mm256_or_si256(
+                same, _mm256_cmpeq_epi8(color, avx2Load(up + x, mask)));
+        if (down)
+            same = _mm256_or_si256(
+                same, _mm256_cmpeq_epi8(color, avx2Load(down + x, mask)));
+        const unsigned legal = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_andnot_si256(_mm256_cmpeq_epi8(color, zero), same)));
+        if (legal) {
+            if (first)
+                return 1;
+            count += __builtin_popcount(legal);
+        }
+    }
+    return count + scalarCells(row, up, down, x, columns, columns, first);
+}
+
+
+// Each color's count is kept in byte lanes, each lane subtracting the -1
+// of a match, and summed before any lane can overflow. Only the colors up
+// to COLORS are counted so that every count stays in a register; empty
+// cells are whatever is left over.
+template<int COLORS>
+__attribute__((target("sse2")))
+int sse2Count(const Cell* cells, int size, ColorCounts& histogram) {
+    const int LANES = 16;
+    const int BLOCK = 255 * LANES;
+    const __m128i mask = _mm_set1_epi8(COLOR_MASK);
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    while (i + LANES <= size) {
+        const int end = i + std::min(BLOCK, (size - i) / LANES * LANES);
+        __m128i counts[COLORS];
+        for (auto& count: counts)
+            count = zero;
+        for (; i < end; i += LANES) {
+            const __m128i color = sse2Load(cells + i, mask);
+            for (int c = 0; c < COLORS; ++c)
+                counts[c] = _mm_sub_epi8(counts[c], _mm_cmpeq_epi8(
+                    color, _mm_set1_epi8(static_cast<char>(c + 1))));
+        }
+        for (int c = 0; c < COLORS; ++c) {
+            const __m128i sums = _mm_sad_epu8(counts[c], zero);
+            histogram[c + 1] += _mm_cvtsi128_si32(sums) +
+                                _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+        }
+    }
+    return i;
+}
+
+
+template<int COLORS>
+__attribute__((target("avx2")))
+int avx2Count(const Cell* cells, int size, ColorCounts& histogram) {
+    const int LANES = 32;
+    const int BLOCK = 255 * LANES;
+    const __m256i mask = _mm256_set1_epi8(COLOR_MASK);
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    while (i + LANES <= size) {
+        const int end = i + std::min(BLOCK, (size - i) / LANES * LANES);
+        __m256i counts[COLORS];
+        for (auto& count: counts)
+            count = zero;
+        for (; i < end; i += LANES) {
+            const __m256i color = avx2Load(cells + i, mask);
+            for (int c = 0; c < COLORS; ++c)
+                counts[c] = _mm256_sub_epi8(counts[c], _mm256_cmpeq_epi8(
+                    color, _mm256_set1_epi8(static_cast<char>(c + 1))));
+        }
+        for (int c = 0; c < COLORS; ++c) {
+            const __m256i sums = _mm256_sad_epu8(counts[c], zero);
+            histogram[c + 1] += static_cast<int>(
+                _mm256_extract_epi64(sums, 0) +
+                _mm256_extract_epi64(sums, 1) +
+                _mm256_extract_epi64(sums, 2) +
+                _mm256_extract_epi64(sums, 3));
+        }
+    }
+    return i;
+}
+
+
+__attribute__((target("sse2")))
+int sse2MaxColor(const Cell* cells, int size) {
+    const int LANES = 16;
+    const __m128i mask = _mm_set1_epi8(COLOR_MASK);
+    __m128i most = _mm_setzero_si128();
+    int i = 0;
+    for (; i + LANES <= size; i += LANES)
+        most = _mm_max_epu8(most, sse2Load(cells + i, mask));
+    alignas(16) Cell lanes[LANES];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), most);
+    int color = *std::max_element(lanes, lanes + LANES);
+    for (; i < size; ++i)
+        color = std::max(color, cells[i] & COLOR_MASK);
+    return color;
+}
+
+
+__attribute__((target("avx2")))
+int avx2MaxColor(const Cell* cells, int size) {
+    const int LANES = 32;
+    const __m256i mask = _mm256_set1_epi8(COLOR_MASK);
+    __m256i most = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + LANES <= size; i += LANES)
+        most = _mm256_max_epu8(most, avx2Load(cells + i, mask));
+    alignas(32) Cell lanes[LANES];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), most);
+    int color = *std::max_element(lanes, lanes + LANES);
+    for (; i < size; ++i)
+        color = std::max(color, cells[i] & COLOR_MASK);
+    return color;
+}
+
+
+// Boards seldom have more than 7 colors, so a first pass finds the most
+// there are; the vector loops then need no more counts than that
+ColorCounts vectorHistogram(const Cell* cells, int size, bool avx2) {
+    ColorCounts histogram{};
+    const int colors = avx2 ? avx2MaxColor(cells, size)
+                            : sse2MaxColor(cells, size);
+    int i;
+    if (colors <= 4)
+        i = avx2 ? avx2Count<4>(cells, size, histogram)
+                 : sse2Count<4>(cells, size, histogram);
+    else if (colors <= 7)
+        i = avx2 ? avx2Count<7>(cells, size, histogram)
+                 : sse2Count<7>(cells, size, histogram);
+    else
+        i = avx2 ? avx2Count<MAX_COLOR_INDEX>(cells, size, histogram)
+                 : sse2Count<MAX_COLOR_INDEX>(cells, size, histogram);
+    int tiles = 0;
+    for (int color = 1; color <= MAX_COLOR_INDEX; ++color)
+        tiles += histogram[color];
+    histogram[NO_COLOR] = i - tiles;
+    const auto rest = scalarHistogram(cells + i, size - i);
+    for (int color = 0; color <= MAX_COLOR_INDEX; ++color)
+        histogram[color] += rest[color];
+    return histogram;
+}
+#endif
+
+
+RowScan rowScan(ScanKernel kernel) {
+    switch (kernel) {
+#ifdef SCAN_X86
+        case ScanKernel::Avx2: return avx2Row;
+        case ScanKernel::Sse2: return sse2Row;
+#endif
+        default: return scalarRow;
+    }
+}
+
+
+int scanLegal(const Grid& tiles, ScanKernel kernel, bool first) {
+    if (!isSupported(kernel))
+        kernel = ScanKernel::Scalar;
+    const auto scan = rowScan(kernel);
+    const int columns = tiles.columns();
+    const int rows = tiles.rows();
+    int count = 0;
+    for (int y = 0; y < rows; ++y) {
+        const Cell* row = tiles.data() + tiles.index(0, y);
+        count += scan(row, y > 0 ? row - columns : nullptr,
+                      y + 1 < rows ? row + columns : nullptr, columns,
+                      first);
+        if (first && count)
+            break;
+    }
+    return count;
+}
+
+} // namespace
+
+
+ScanKernel bestScanKernel() {
+    static const ScanKernel best = isSupported(ScanKernel::Avx2)
+        ? ScanKernel::Avx2 : isSupported(ScanKernel::Sse2)
+        ? ScanKernel::Sse2 : ScanKernel::Scalar;
+    return best;
+}
+
+
+bool isSupported(ScanKernel kernel) {
+    switch (kernel) {
+#ifdef SCAN_X86
+        case ScanKernel::Avx2: return __builtin_cpu_supports("avx2");
+        case ScanKernel::Sse2: return __builtin_cpu_supports("sse2");
+#endif
+        case ScanKernel::Scalar: return true;
+        default: return false;
+    }
+}
+
+
+const char* kernelName(ScanKernel kernel) {
+    switch (kernel) {
+        case ScanKernel::Avx2: return "avx2";
+        case ScanKernel::Sse2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+
+bool hasLegalCell(const Grid& tiles, ScanKernel kernel) {
+    return scanLegal(tiles, kernel, true) > 0;
+}
+
+
+int legalCellCount(const Grid& tiles, ScanKernel kernel) {
+    return scanLegal(tiles, kernel, false);
+}
+
+
+// Counts every color index, NO_COLOR (empty cells) included
+ColorCounts colorHistogram(const Grid& tiles, ScanKernel kernel) {
+    if (!isSupported(kernel))
+        kernel = ScanKernel::Scalar;
+    switch (kernel) {
+#ifdef SCAN_X86
+        case ScanKernel::Avx2: return vectorHistogram(tiles.data(),
+                                                      tiles.size(), true);
+        case ScanKernel::Sse2: return vectorHistogram(tiles.data(),
+                                                      tiles.size(), false);
+#endif
+        default: return scalarHistogram(tiles.data(), tiles.size());
+    }
+}
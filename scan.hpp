@@ -0,0 +1,32 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    Whole-board scans of a grid with no wx dependency. A cell is legal if
+    it has a tile with a same-colored neighbour. Each scan compares a row
+    with its shifted self and the rows above and below 16 (SSE2) or 32
+    (AVX2) cells at a time; the fastest kernel the CPU supports is chosen
+    at runtime, and there is always a scalar fallback. The engine keeps
+    these figures up to date incrementally, so the scans are for checking
+    it and for boards that don't come from an engine.
+*/
+
+#include "grid.hpp"
+
+#include <array>
+
+
+enum class ScanKernel { Scalar, Sse2, Avx2 };
+
+using ColorCounts = std::array<int, MAX_COLOR_INDEX + 1>; // By color
+
+
+ScanKernel bestScanKernel();
+bool isSupported(ScanKernel kernel);
+const char* kernelName(ScanKernel kernel);
+
+bool hasLegalCell(const Grid& tiles, ScanKernel kernel=bestScanKernel());
+int legalCellCount(const Grid& tiles, ScanKernel kernel=bestScanKernel());
+ColorCounts colorHistogram(const Grid& tiles,
+                           ScanKernel kernel=bestScanKernel());
@@ -0,0 +1,394 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include "scoredb.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+
+namespace {
+
+const char LOG_MAGIC[] = "GRVL";
+const char INDEX_MAGIC[] = "GRVI";
+const std::uint32_t SCOREDB_VERSION = 1;
+const std::uint32_t BYTE_ORDER_CHECK = 0x01020304; // Differs if swapped
+const std::uint32_t CONFIGURATIONS_LIMIT = 1 << 16; // Sanity check
+const size_t CHUNK_SIZE = 4096; // Records read at a time when catching up
+
+static_assert(sizeof(GameRecord) == 48, "Game records must not be padded");
+
+const size_t CHECKED_RECORD_SIZE = offsetof(GameRecord, checksum);
+
+
+struct LogHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint32_t recordSize;
+};
+
+
+struct IndexHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint32_t configurations;
+    std::uint64_t records; // How many of the log's records are included
+    std::uint64_t checksum; // Of the entries
+};
+
+
+struct IndexLeader {
+    std::int64_t score;
+    std::uint32_t number;
+    std::uint32_t reserved;
+};
+
+
+struct IndexEntry {
+    std::uint32_t columns;
+    std::uint32_t rows;
+    std::uint32_t maxColors;
+    std::uint32_t leaderCount;
+    std::int64_t games;
+    std::int64_t wins;
+    double totalScore;
+    std::int64_t best;
+    std::int64_t worst;
+    IndexLeader leaders[LEADERBOARD_SIZE];
+    std::uint32_t histogram[HISTOGRAM_BUCKETS];
+};
+
+static_assert(sizeof(IndexEntry) == 56 + 16 * LEADERBOARD_SIZE +
+              4 * HISTOGRAM_BUCKETS, "Index entries must not be padded");
+
+
+// FNV-1a: records and index entries are small so bytewise is fast enough
+std::uint64_t checksum(const void* data, size_t size,
+                       std::uint64_t sum=0xCBF29CE484222325ULL) {
+    const auto bytes = static_cast<const std::uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i)
+        sum = (sum ^ bytes[i]) * 0x100000001B3ULL;
+    return sum;
+}
+
+
+std::uint32_t recordChecksum(const GameRecord& record) {
+    const auto sum = checksum(&record, CHECKED_RECORD_SIZE);
+    return static_cast<std::uint32_t>(sum ^ (sum >> 32));
+}
+
+
+std::streamoff recordOffset(std::uint32_t number) {
+    return static_cast<std::streamoff>(sizeof(LogHeader)) +
+           static_cast<std::streamoff>(number) * sizeof(GameRecord);
+}
+
+
+// Scores below 8 have a bucket each; above that each power of 2 is split
+// into 8 buckets by the 3 bits after the leading 1
+int bucket(Score score) {
+    if (score < 8)
+        return score < 0 ? 0 : static_cast<int>(score);
+    const auto value = static_cast<std::uint64_t>(score);
+    int bits = 4;
+    while (value >> bits)
+        ++bits;
+    const int shift = bits - 4;
+    return 8 + shift * 8 + static_cast<int>((value >> shift) & 7);
+}
+
+
+// The middle of the range of scores that fall into the bucket
+Score bucketMiddle(int index) {
+    if (index < 8)
+        return index;
+    const int shift = (index - 8) / 8;
+    const Score lowest = static_cast<Score>(8 + (index - 8) % 8) << shift;
+    return lowest + ((Score(1) << shift) - 1) / 2;
+}
+
+} // namespace
+
+
+Score ConfigurationStats::percentile(double fraction) const {
+    if (!games)
+        return 0;
+    const auto rank = std::clamp(
+        static_cast<std::int64_t>(std::ceil(fraction * games)),
+        std::int64_t(1), games);
+    std::int64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        seen += histogram[i];
+        if (seen >= rank)
+            return std::clamp(bucketMiddle(i), worst, best);
+    }
+    return best;
+}
+
+
+// Creates the log if there isn't one; returns false if the log can't be
+// created or isn't a score log. Only the records the index doesn't cover
+// are read, so this is only slow if the index must be rebuilt.
+bool ScoreDb::open(const std::string& logFilename_,
+                   const std::string& indexFilename_) {
+    close();
+    logFilename = logFilename_;
+    indexFilename = indexFilename_;
+    count = 0;
+    stats_.clear();
+    std::ifstream file(logFilename, std::ios::binary | std::ios::ate);
+    if (!file) {
+        LogHeader header{};
+        std::memcpy(header.magic, LOG_MAGIC, sizeof(header.magic));
+        header.version = SCOREDB_VERSION;
+        header.byteOrder = BYTE_ORDER_CHECK;
+        header.recordSize = sizeof(GameRecord);
+        log.open(logFilename, std::ios::binary | std::ios::out);
+        log.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!log.flush() || !saveIndex()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+    const auto size = static_cast<std::streamoff>(file.tellg());
+    LogHeader header;
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, LOG_MAGIC, sizeof(header.magic)) ||
+            header.version != SCOREDB_VERSION ||
+            header.byteOrder != BYTE_ORDER_CHECK ||
+            header.recordSize != sizeof(GameRecord)) {
+        logFilename.clear(); // So add() can't overwrite some other file
+        return false;
+    }
+    // A torn final record is ignored and overwritten by the next add()
+    count = static_cast<std::uint32_t>(
+        (size - static_cast<std::streamoff>(sizeof(header))) /
+        static_cast<std::streamoff>(sizeof(GameRecord)));
+    std::uint32_t covered = 0;
+    if (!readIndex(covered) || covered > count) { // Missing or stale
+        stats_.clear();
+        covered = 0;
+    }
+    log.open(logFilename, std::ios::binary | std::ios::in | std::ios::out);
+    if (!log) {
+        logFilename.clear();
+        return false;
+    }
+    if (covered == count)
+        return true;
+    std::vector<GameRecord> records(CHUNK_SIZE);
+    file.seekg(recordOffset(covered));
+    for (auto number = covered; number < count;) {
+        const auto n = std::min<size_t>(CHUNK_SIZE, count - number);
+        if (!file.read(reinterpret_cast<char*>(records.data()),
+                       static_cast<std::streamsize>(n * sizeof(GameRecord))))
+            return false;
+        for (size_t i = 0; i < n; ++i, ++number)
+            if (records[i].checksum == recordChecksum(records[i]))
+                include(number, records[i]);
+    }
+    saveIndex();
+    return true;
+}
+
+
+// Appends the game and updates the index. Returns false if the game
+// couldn't be appended; failing to save the index doesn't matter since
+// open() catches up with the log.
+// Saves the index if records have been added since it was last saved
+bool ScoreDb::close() {
+    if (!log.is_open())
+        return true;
+    const bool ok = !unsaved || saveIndex();
+    log.close();
+    unsaved = 0;
+    return ok;
+}
+
+
+// The log is flushed so a crash loses at most this record; the index
+// needn't be saved since open() catches up from the log
+bool ScoreDb::add(GameRecord record) {
+    if (logFilename.empty() || !log.is_open())
+        return false;
+    record.checksum = recordChecksum(record);
+    log.clear();
+    log.seekp(recordOffset(count)); // Over any torn final record
+    log.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    if (!log.flush())
+        return false;
+    include(count++, record);
+    if (++unsaved >= INDEX_SAVE_INTERVAL && saveIndex())
+        unsaved = 0;
+    return true;
+}
+
+
+// Returns false if there's no such record or it is damaged
+bool ScoreDb::read(std::uint32_t number, GameRecord& record) const {
+    if (number >= count)
+        return false;
+    std::ifstream file(logFilename, std::ios::binary);
+    file.seekg(recordOffset(number));
+    GameRecord candidate;
+    if (!file.read(reinterpret_cast<char*>(&candidate), sizeof(candidate))
+            || candidate.checksum != recordChecksum(candidate))
+        return false;
+    record = candidate;
+    return true;
+}
+
+
+const ConfigurationStats* ScoreDb::stats(
+        const Configuration& configuration) const {
+    const auto i = stats_.find(configuration);
+    return i == stats_.cend() ? nullptr : &i->second;
+}
+
+
+// Reads only the leaders' records, best first
+std::vector<GameRecord> ScoreDb::leaderboard(
+        const Configuration& configuration) const {
+    std::vector<GameRecord> records;
+    const auto configurationStats = stats(configuration);
+    if (!configurationStats)
+        return records;
+    for (const auto& leader: configurationStats->leaders) {
+        GameRecord record;
+        if (read(leader.number, record))
+            records.push_back(record);
+    }
+    return records;
+}
+
+
+void ScoreDb::include(std::uint32_t number, const GameRecord& record) {
+    const Configuration configuration{static_cast<int>(record.columns),
+                                      static_cast<int>(record.rows),
+                                      static_cast<int>(record.maxColors)};
+    auto& stats = stats_[configuration];
+    const Score score = record.score;
+    if (!stats.games++)
+        stats.best = stats.worst = score;
+    else {
+        stats.best = std::max(stats.best, score);
+        stats.worst = std::min(stats.worst, score);
+    }
+    if (record.won)
+        ++stats.wins;
+    stats.totalScore += static_cast<double>(score);
+    ++stats.histogram[bucket(score)];
+    auto& leaders = stats.leaders;
+    // Of equal scores the earliest ranks highest
+    const auto i = std::upper_bound(
+        leaders.begin(), leaders.end(), score,
+        [](Score score, const Leader& leader) {
+            return score > leader.score; });
+    if (i - leaders.begin() < LEADERBOARD_SIZE) {
+        leaders.insert(i, {score, number});
+        if (leaders.size() > LEADERBOARD_SIZE)
+            leaders.pop_back();
+    }
+}
+
+
+// Returns false, leaving the stats empty, if there's no valid index
+bool ScoreDb::readIndex(std::uint32_t& covered) {
+    std::ifstream file(indexFilename, std::ios::binary);
+    IndexHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) ||
+            header.version != SCOREDB_VERSION ||
+            header.byteOrder != BYTE_ORDER_CHECK ||
+            header.configurations > CONFIGURATIONS_LIMIT)
+        return false;
+    std::vector<IndexEntry> entries(header.configurations);
+    if (!file.read(reinterpret_cast<char*>(entries.data()),
+                   static_cast<std::streamsize>(entries.size() *
+                                                sizeof(IndexEntry))) ||
+            checksum(entries.data(), entries.size() * sizeof(IndexEntry))
+                != header.checksum)
+        return false;
+    for (const auto& entry: entries) {
+        if (entry.leaderCount > LEADERBOARD_SIZE) {
+            stats_.clear();
+            return false;
+        }
+        auto& stats = stats_[{static_cast<int>(entry.columns),
+                              static_cast<int>(entry.rows),
+                              static_cast<int>(entry.maxColors)}];
+        stats.games = entry.games;
+        stats.wins = entry.wins;
+        stats.totalScore = entry.totalScore;
+        stats.best = entry.best;
+        stats.worst = entry.worst;
+        for (std::uint32_t i = 0; i < entry.leaderCount; ++i)
+            stats.leaders.push_back({entry.leaders[i].score,
+                                     entry.leaders[i].number});
+        std::copy(std::begin(entry.histogram), std::end(entry.histogram),
+                  stats.histogram.begin());
+    }
+    covered = static_cast<std::uint32_t>(header.records);
+    return true;
+}
+
+
+// Like snapshots, written to a temporary file that replaces the old index
+// once it is complete
+bool ScoreDb::saveIndex() const {
+    std::vector<IndexEntry> entries;
+    entries.reserve(stats_.size());
+    for (const auto& [configuration, stats]: stats_) {
+        IndexEntry entry{};
+        entry.columns = static_cast<std::uint32_t>(configuration.columns);
+        entry.rows = static_cast<std::uint32_t>(configuration.rows);
+        entry.maxColors = static_cast<std::uint32_t>(
+            configuration.maxColors);
+        entry.leaderCount = static_cast<std::uint32_t>(
+            stats.leaders.size());
+        entry.games = stats.games;
+        entry.wins = stats.wins;
+        entry.totalScore = stats.totalScore;
+        entry.best = stats.best;
+        entry.worst = stats.worst;
+        for (size_t i = 0; i < stats.leaders.size(); ++i)
+            entry.leaders[i] = {stats.leaders[i].score,
+                                stats.leaders[i].number, 0};
+        std::copy(stats.histogram.cbegin(), stats.histogram.cend(),
+                  entry.histogram);
+        entries.push_back(entry);
+    }
+    IndexHeader header{};
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.version = SCOREDB_VERSION;
+    header.byteOrder = BYTE_ORDER_CHECK;
+    header.configurations = static_cast<std::uint32_t>(entries.size());
+    header.records = count;
+    header.checksum = checksum(entries.data(),
+                               entries.size() * sizeof(IndexEntry));
+    const auto temporary = indexFilename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(entries.data()),
+                   static_cast<std::streamsize>(entries.size() *
+                                                sizeof(IndexEntry)));
+        if (!file.flush()) {
+            file.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), indexFilename.c_str()) == 0)
+        return true;
+    std::remove(indexFilename.c_str()); // Windows won't rename over a file
+    return std::rename(temporary.c_str(), indexFilename.c_str()) == 0;
+}
@@ -0,0 +1,108 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    A record of every finished game. Games are appended to a log of
+    fixed-size records, so adding one is an O(1) append and any game can
+    be read by its number. A separate index keeps a summary for each
+    configuration (board size and color count): the game and win counts,
+    the score total, the best games, and a log-scale histogram of the
+    scores for percentiles, so statistics and leaderboards need no
+    scanning however many games there are. The index notes how many
+    records it covers: when the database is opened any records appended
+    since it was saved are added, and if it is missing or invalid it is
+    rebuilt from the log. So add() only appends to the log, which is kept
+    open, and the index is saved every INDEX_SAVE_INTERVAL adds and by
+    close() (or the destructor).
+*/
+
+#include "engine.hpp"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+
+const int LEADERBOARD_SIZE = 10;
+const int HISTOGRAM_BUCKETS = 512; // 8 per power of 2, so within 1/16
+const int INDEX_SAVE_INTERVAL = 64; // Adds between index saves
+
+
+// Every field is naturally aligned so the layout has no padding
+struct GameRecord {
+    std::uint32_t columns = 0;
+    std::uint32_t rows = 0;
+    std::uint32_t maxColors = 0;
+    std::uint32_t seed = 0;
+    std::int64_t score = 0;
+    std::uint32_t moves = 0;
+    std::uint32_t durationMs = 0; // Time played since dealt or resumed
+    std::int64_t finished = 0; // Seconds since the Unix epoch
+    std::uint32_t won = 0;
+    std::uint32_t checksum = 0; // Of the other fields; set by add()
+};
+
+
+struct Leader {
+    Score score;
+    std::uint32_t number; // The game's record number
+};
+
+
+struct ConfigurationStats {
+    double meanScore() const { return games ? totalScore / games : 0; }
+    double winRate() const {
+        return games ? static_cast<double>(wins) / games : 0;
+    }
+    Score percentile(double fraction) const; // Approximate: see above
+
+    std::int64_t games = 0;
+    std::int64_t wins = 0;
+    double totalScore = 0; // A double since the sum could overflow
+    Score best = 0;
+    Score worst = 0;
+    std::vector<Leader> leaders; // Best first; at most LEADERBOARD_SIZE
+    std::array<std::uint32_t, HISTOGRAM_BUCKETS> histogram{};
+};
+
+
+class ScoreDb {
+public:
+    ScoreDb() {}
+    ScoreDb(const ScoreDb&) = delete;
+    ScoreDb& operator=(const ScoreDb&) = delete;
+    ~ScoreDb() { close(); }
+
+    bool open(const std::string& logFilename,
+              const std::string& indexFilename);
+    bool close();
+    bool add(GameRecord record);
+    bool read(std::uint32_t number, GameRecord& record) const;
+
+    std::uint32_t size() const { return count; } // Records in the log
+    // Returns nullptr if no game of the configuration has been played
+    const ConfigurationStats* stats(const Configuration& configuration)
+        const;
+    std::vector<GameRecord> leaderboard(
+        const Configuration& configuration) const;
+    const std::map<Configuration, ConfigurationStats>& configurations()
+            const {
+        return stats_;
+    }
+
+private:
+    void include(std::uint32_t number, const GameRecord& record);
+    bool readIndex(std::uint32_t& covered);
+    bool saveIndex() const;
+
+    std::string logFilename;
+    std::string indexFilename;
+    std::fstream log; // Open from open() to close() for add()
+    std::uint32_t count = 0; // Records in the log
+    int unsaved = 0; // Records added since the index was saved
+    std::map<Configuration, ConfigurationStats> stats_;
+};
@@ -0,0 +1,137 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include "constants.hpp"
+#include "scoreswindow.hpp"
+#include "settings.hpp"
+#include "util.hpp"
+
+#include <wx/artprov.h>
+#include <wx/datetime.h>
+#include <wx/html/htmlwin.h>
+
+
+void onScores(MainWindow* parent, const ScoreDb& scores) {
+    ScoresWindow scoresWindow(parent, scores);
+    scoresWindow.ShowModal();
+}
+
+
+namespace {
+
+const wxString HTML_TEXT(LR"RAW(<html>
+<body style="background-color: %s;">
+<center><font size=+2 color=navy><b>%s</b></font></center>
+%s
+</body></html>)RAW");
+
+
+wxString describe(const Configuration& configuration) {
+    return wxString::Format(L"%d × %d, %d colors", configuration.columns,
+                            configuration.rows, configuration.maxColors);
+}
+
+
+wxString percent(double fraction) {
+    return wxString::Format("%.0f%%", fraction * 100);
+}
+
+
+wxString statsHtml(const ConfigurationStats& stats) {
+    return wxString::Format(
+        "<table>"
+        "<tr><td>Games</td><td align=right>%s</td></tr>"
+        "<tr><td>Won</td><td align=right>%s (%s)</td></tr>"
+        "<tr><td>Best</td><td align=right>%s</td></tr>"
+        "<tr><td>Mean</td><td align=right>%s</td></tr>"
+        "<tr><td>Median</td><td align=right>about %s</td></tr>"
+        "<tr><td>90th percentile</td><td align=right>about %s</td></tr>"
+        "</table>",
+        humanize(stats.games), humanize(stats.wins),
+        percent(stats.winRate()), humanize(stats.best),
+        humanize(static_cast<long long>(stats.meanScore() + 0.5)),
+        humanize(stats.percentile(0.5)), humanize(stats.percentile(0.9)));
+}
+
+
+wxString leaderboardHtml(const std::vector<GameRecord>& records) {
+    wxString html("<table><tr><td><font color=\"#004E00\">#</font></td>"
+                  "<td><font color=\"#004E00\">Score</font></td>"
+                  "<td><font color=\"#004E00\">Seed</font></td>"
+                  "<td><font color=\"#004E00\">Moves</font></td>"
+                  "<td><font color=\"#004E00\">Time</font></td>"
+                  "<td><font color=\"#004E00\">Date</font></td></tr>");
+    int rank = 0;
+    for (const auto& record: records) {
+        const auto seconds = record.durationMs / 1000;
+        html += wxString::Format(
+            "<tr><td>%d</td><td align=right>%s%s%s</td><td>%u</td>"
+            "<td align=right>%u</td><td align=right>%u:%02u</td>"
+            "<td>%s</td></tr>", ++rank,
+            record.won ? "<b>" : "", humanize(record.score),
+            record.won ? "</b>" : "", record.seed,
+            record.moves, seconds / 60, seconds % 60,
+            wxDateTime(static_cast<time_t>(record.finished))
+                .FormatISODate());
+    }
+    return html + "</table><p><font size=-1>Scores of games won are in "
+                  "<b>bold</b>.</font></p>";
+}
+
+
+wxString othersHtml(const ScoreDb& scores, const Configuration& current) {
+    wxString html;
+    for (const auto& [configuration, stats]: scores.configurations()) {
+        if (configuration == current)
+            continue;
+        html += wxString::Format(
+            "<tr><td>%s</td><td align=right>%s</td>"
+            "<td align=right>%s</td><td align=right>%s</td></tr>",
+            describe(configuration), humanize(stats.games),
+            percent(stats.winRate()), humanize(stats.best));
+    }
+    if (html.IsEmpty())
+        return html;
+    return "<hr><p><font color=navy>Other Boards</font></p><table>"
+           "<tr><td><font color=\"#004E00\">Board</font></td>"
+           "<td><font color=\"#004E00\">Games</font></td>"
+           "<td><font color=\"#004E00\">Won</font></td>"
+           "<td><font color=\"#004E00\">Best</font></td></tr>" + html +
+           "</table>";
+}
+
+} // namespace
+
+
+// Only the index and the leaders' records are read, however many games
+// have been played
+ScoresWindow::ScoresWindow(wxWindow* parent, const ScoreDb& scores)
+        : wxDialog(parent, wxID_ANY,
+                   wxString::Format(L"Scores — %s", wxTheApp->GetAppName()),
+                   wxDefaultPosition, wxSize(450, 550), FRAME_STYLE) {
+    SetIcon(wxArtProvider::GetIcon(ICON_ID));
+    SetMinSize(wxSize(200, 200));
+    const auto& options = Settings::get().board();
+    const Configuration current{options.columns, options.rows,
+                                options.maxColors};
+    wxString body;
+    if (const auto stats = scores.stats(current))
+        body = statsHtml(*stats) + "<hr>" +
+               leaderboardHtml(scores.leaderboard(current));
+    else
+        body = "<p><center>No games on this board have been finished "
+               "yet.</center></p>";
+    body += othersHtml(scores, current);
+    auto htmlLabel = new wxHtmlWindow(this);
+    const auto background = wxSystemSettings::GetColour(
+        wxSYS_COLOUR_BTNFACE);
+    htmlLabel->SetPage(wxString::Format(
+        HTML_TEXT, background.GetAsString(wxC2S_HTML_SYNTAX),
+        describe(current), body));
+    auto okButton = new wxButton(this, wxID_OK, "&OK");
+    okButton->SetDefault();
+    auto sizer = new wxBoxSizer(wxVERTICAL);
+    sizer->Add(htmlLabel, 1, wxALL | wxEXPAND, 3);
+    sizer->Add(okButton, 0, wxALL | wxALIGN_CENTER, 3);
+    SetSizer(sizer);
+}
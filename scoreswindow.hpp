@@ -0,0 +1,22 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include <wx/wxprec.h>
+#ifndef WX_PRECOMP
+    #include <wx/wx.h>
+#endif
+
+#include "mainwindow.hpp"
+#include "scoredb.hpp"
+
+
+void onScores(MainWindow* parent, const ScoreDb& scores);
+
+
+// The statistics and leaderboard for the configuration in the options,
+// and a summary of every other configuration played
+class ScoresWindow : public wxDialog {
+public:
+    ScoresWindow(wxWindow* parent, const ScoreDb& scores);
+};
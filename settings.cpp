@@ -0,0 +1,125 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include "settings.hpp"
+#include "trace.hpp"
+
+#include <wx/config.h>
+
+#include <algorithm>
+#include <memory>
+
+
+// Never destroyed, so changes can still be flushed at exit; first used on
+// the GUI thread, which then owns it
+Settings& Settings::get() {
+    static Settings* settings = new Settings;
+    return *settings;
+}
+
+
+Settings::Settings()
+        : appName(wxTheApp->GetAppName()), nextId(0), dirty(false) {
+    read();
+    flushTimer.Bind(wxEVT_TIMER, [&](wxTimerEvent&) { flush(); });
+}
+
+
+void Settings::read() {
+    TRACE_SCOPE("settings/read");
+    std::unique_ptr<wxConfig> config(new wxConfig(appName));
+    auto& board = values.board;
+    config->Read(COLUMNS, &board.columns, COLUMNS_DEFAULT);
+    config->Read(ROWS, &board.rows, ROWS_DEFAULT);
+    config->Read(MAX_COLORS, &board.maxColors, MAX_COLORS_DEFAULT);
+    config->Read(DELAY_MS, &board.delayMs, DELAY_MS_DEFAULT);
+    config->Read(HINT_MS, &board.hintMs, HINT_MS_DEFAULT);
+    config->Read(SOLVABLE_ONLY, &board.solvableOnly, false);
+    // Scores are 64-bit so they are stored as text
+    wxString text;
+    wxLongLong_t highScore;
+    if (config->Read(HIGH_SCORE, &text) && text.ToLongLong(&highScore))
+        values.highScore = highScore;
+    else { // Stored as a number by older versions
+        long oldHighScore;
+        config->Read(HIGH_SCORE, &oldHighScore, HIGH_SCORE_DEFAULT);
+        values.highScore = oldHighScore;
+    }
+    auto& window = values.window;
+    config->Read(WINDOW_X, &window.x, -1);
+    config->Read(WINDOW_Y, &window.y, -1);
+    config->Read(WINDOW_WIDTH, &window.width, 380);
+    config->Read(WINDOW_HEIGHT, &window.height, 440);
+}
+
+
+void Settings::setBoard(const BoardOptions& board) {
+    values.board = board;
+    changed(SettingsChange::Board);
+}
+
+
+void Settings::setHighScore(Score highScore) {
+    values.highScore = highScore;
+    changed(SettingsChange::HighScore);
+}
+
+
+void Settings::setWindow(const wxRect& window) {
+    values.window = window;
+    changed(SettingsChange::Window);
+}
+
+
+int Settings::listen(Listener listener) {
+    listeners.emplace_back(++nextId, std::move(listener));
+    return nextId;
+}
+
+
+void Settings::unlisten(int id) {
+    listeners.erase(std::remove_if(listeners.begin(), listeners.end(),
+                                   [id](const auto& listener) {
+                        return listener.first == id; }),
+                    listeners.end());
+}
+
+
+// Each change puts off the write, so it only happens once changes stop
+void Settings::changed(SettingsChange change) {
+    dirty = true;
+    flushTimer.StartOnce(FLUSH_DELAY_MS);
+    for (const auto& listener: listeners)
+        listener.second(change);
+}
+
+
+// Writes any pending changes now, e.g., as the app quits
+void Settings::flush() {
+    flushTimer.Stop();
+    if (dirty)
+        write();
+    dirty = false;
+}
+
+
+// Only called by flush()
+void Settings::write() {
+    TRACE_SCOPE("settings/write");
+    std::unique_ptr<wxConfig> config(new wxConfig(appName));
+    const auto& board = values.board;
+    config->Write(COLUMNS, board.columns);
+    config->Write(ROWS, board.rows);
+    config->Write(MAX_COLORS, board.maxColors);
+    config->Write(DELAY_MS, board.delayMs);
+    config->Write(HINT_MS, board.hintMs);
+    config->Write(SOLVABLE_ONLY, board.solvableOnly);
+    config->Write(HIGH_SCORE, wxString::Format("%lld",
+                  static_cast<long long>(values.highScore)));
+    const auto& window = values.window;
+    config->Write(WINDOW_X, window.x);
+    config->Write(WINDOW_Y, window.y);
+    config->Write(WINDOW_WIDTH, window.width);
+    config->Write(WINDOW_HEIGHT, window.height);
+    config->Flush();
+}
@@ -0,0 +1,83 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    The app's settings, read from the config once and then kept in memory
+    so that reading a setting never touches a file. A change is made in
+    memory at once and passed on to every listener; the config is written
+    on the GUI thread (wxConfig isn't thread-safe) by a timer once there
+    have been no changes for FLUSH_DELAY_MS, so a burst of changes costs
+    a single write. flush() writes any pending changes at once, e.g.,
+    when the app is closed.
+*/
+
+#include "constants.hpp"
+#include "engine.hpp"
+
+#include <wx/wxprec.h>
+#ifndef WX_PRECOMP
+    #include <wx/wx.h>
+#endif
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+
+const int FLUSH_DELAY_MS = 1000;
+
+
+struct BoardOptions {
+    int columns = COLUMNS_DEFAULT;
+    int rows = ROWS_DEFAULT;
+    int maxColors = MAX_COLORS_DEFAULT;
+    int delayMs = DELAY_MS_DEFAULT;
+    int hintMs = HINT_MS_DEFAULT;
+    bool solvableOnly = false; // Only deal boards proven winnable
+};
+
+
+enum class SettingsChange { Board, HighScore, Window };
+
+
+class Settings {
+public:
+    using Listener = std::function<void(SettingsChange)>;
+
+    static Settings& get(); // Reads the config on first use
+
+    Settings(const Settings&) = delete;
+    Settings& operator=(const Settings&) = delete;
+
+    const BoardOptions& board() const { return values.board; }
+    void setBoard(const BoardOptions& board);
+    Score highScore() const { return values.highScore; }
+    void setHighScore(Score highScore);
+    // The window's position is (-1, -1) if it has never been saved
+    const wxRect& window() const { return values.window; }
+    void setWindow(const wxRect& window);
+
+    int listen(Listener listener); // Returns the ID to pass to unlisten()
+    void unlisten(int id);
+    void flush();
+
+private:
+    struct Values {
+        BoardOptions board;
+        Score highScore = HIGH_SCORE_DEFAULT;
+        wxRect window{-1, -1, 380, 440};
+    };
+
+    Settings();
+    void read();
+    void changed(SettingsChange change);
+    void write();
+
+    const wxString appName;
+    Values values;
+    std::vector<std::pair<int, Listener>> listeners;
+    int nextId;
+    bool dirty; // values has changes that aren't written yet
+    wxTimer flushTimer; // Restarted by every change
+};
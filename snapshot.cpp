@@ -0,0 +1,265 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include "snapshot.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+
+namespace {
+
+const char MAGIC[] = "GRVS";
+const std::uint32_t BYTE_ORDER_CHECK = 0x01020304; // Differs if swapped
+
+// Every field is naturally aligned so the layout has no padding
+struct Header {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint32_t columns;
+    std::uint32_t rows;
+    std::uint32_t maxColors;
+    std::uint32_t seed;
+    std::int32_t selectedX;
+    std::int32_t selectedY;
+    std::uint32_t reserved;
+    std::int64_t score;
+    std::uint64_t randomizer[4];
+    std::uint64_t historySize;
+    std::uint8_t palette[MAX_COLOR_INDEX + 1]; // Only maxColors are used
+    std::uint64_t checksum; // Of the rest of the header and the body
+};
+
+static_assert(sizeof(Header) == 112, "Snapshot header must not be padded");
+
+const size_t CHECKED_HEADER_SIZE = offsetof(Header, checksum);
+
+
+size_t paddedCellsSize(const Header& header) {
+    const size_t size = static_cast<size_t>(header.columns) * header.rows;
+    return (size + 3) & ~size_t(3);
+}
+
+
+// FNV-1a over 64-bit words with an extra shift to mix in the high bits;
+// fast enough to check a huge board's cells in a few milliseconds
+std::uint64_t checksum(const std::uint8_t* data, size_t size,
+                       std::uint64_t sum=0xCBF29CE484222325ULL) {
+    const std::uint64_t PRIME = 0x100000001B3ULL;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        sum = (sum ^ word) * PRIME;
+        sum ^= sum >> 29;
+    }
+    for (; i < size; ++i)
+        sum = (sum ^ data[i]) * PRIME;
+    return sum;
+}
+
+
+// A read-only view of a whole file; data() is nullptr if the file can't
+// be mapped (e.g., it doesn't exist or is empty)
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const std::uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const std::uint8_t* data_;
+    size_t size_;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& filename)
+        : data_(nullptr), size_(0), file(INVALID_HANDLE_VALUE),
+          mapping(nullptr) {
+    file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                       nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                       nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+        return;
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0,
+                                 nullptr);
+    if (!mapping)
+        return;
+    data_ = static_cast<const std::uint8_t*>(
+        MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data_)
+        size_ = static_cast<size_t>(size.QuadPart);
+}
+
+
+MappedFile::~MappedFile() {
+    if (data_)
+        UnmapViewOfFile(data_);
+    if (mapping)
+        CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+}
+#else
+MappedFile::MappedFile(const std::string& filename)
+        : data_(nullptr), size_(0) {
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+        return;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* data = mmap(nullptr, static_cast<size_t>(info.st_size),
+                          PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            data_ = static_cast<const std::uint8_t*>(data);
+            size_ = static_cast<size_t>(info.st_size);
+        }
+    }
+    close(fd); // The mapping stays valid
+}
+
+
+MappedFile::~MappedFile() {
+    if (data_)
+        munmap(const_cast<std::uint8_t*>(data_), size_);
+}
+#endif
+
+} // namespace
+
+
+// Writes to a temporary file that replaces the old snapshot once it is
+// complete, so a failed save never leaves a half-written snapshot
+bool saveSnapshot(const std::string& filename, const Engine& engine,
+                  const Point& selected) {
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = BYTE_ORDER_CHECK;
+    header.columns = static_cast<std::uint32_t>(engine.columns());
+    header.rows = static_cast<std::uint32_t>(engine.rows());
+    header.maxColors = static_cast<std::uint32_t>(engine.maxColors());
+    header.seed = engine.seed();
+    header.selectedX = selected.x;
+    header.selectedY = selected.y;
+    header.score = engine.score();
+    const auto state = engine.randomizer().state();
+    std::copy(state.cbegin(), state.cend(), header.randomizer);
+    header.historySize = engine.history().size();
+    const auto& palette = engine.palette();
+    for (size_t i = 0; i < palette.size(); ++i)
+        header.palette[i] = static_cast<std::uint8_t>(palette[i]);
+    const auto& grid = engine.grid();
+    std::vector<std::uint32_t> history;
+    history.reserve(engine.history().size());
+    for (const auto& point: engine.history())
+        history.push_back(static_cast<std::uint32_t>(
+            grid.index(point.x, point.y)));
+    const auto historyBytes = reinterpret_cast<const std::uint8_t*>(
+        history.data());
+    const size_t historySize = history.size() * sizeof(std::uint32_t);
+    auto sum = checksum(reinterpret_cast<const std::uint8_t*>(&header),
+                        CHECKED_HEADER_SIZE);
+    std::vector<std::uint8_t> body(grid.data(), grid.data() + grid.size());
+    body.resize(paddedCellsSize(header)); // Pads with 0s
+    body.insert(body.end(), historyBytes, historyBytes + historySize);
+    header.checksum = checksum(body.data(), body.size(), sum);
+    const auto temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(body.data()),
+                   static_cast<std::streamsize>(body.size()));
+        if (!file.flush()) {
+            file.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), filename.c_str()) == 0)
+        return true;
+    std::remove(filename.c_str()); // Windows won't rename over a file
+    return std::rename(temporary.c_str(), filename.c_str()) == 0;
+}
+
+
+// Returns false (and leaves the engine unchanged) if there is no valid
+// snapshot in the file
+bool loadSnapshot(const std::string& filename, Engine& engine,
+                  Point& selected) {
+    const MappedFile file(filename);
+    if (file.size() < sizeof(Header))
+        return false;
+    Header header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(header.magic)) ||
+            header.version != SNAPSHOT_VERSION ||
+            header.byteOrder != BYTE_ORDER_CHECK ||
+            header.columns < 1 || header.columns > BOARD_SIZE_MAX ||
+            header.rows < 1 || header.rows > BOARD_SIZE_MAX ||
+            header.maxColors > MAX_COLOR_INDEX + 1u)
+        return false;
+    const size_t cellsSize = paddedCellsSize(header);
+    const size_t bodySize = file.size() - sizeof(Header);
+    if (bodySize < cellsSize ||
+            (bodySize - cellsSize) / sizeof(std::uint32_t) !=
+                header.historySize ||
+            (bodySize - cellsSize) % sizeof(std::uint32_t))
+        return false;
+    const auto body = file.data() + sizeof(Header);
+    const auto sum = checksum(file.data(), CHECKED_HEADER_SIZE);
+    if (checksum(body, bodySize, sum) != header.checksum)
+        return false;
+    const PaletteIndexes palette(header.palette,
+                                 header.palette + header.maxColors);
+    Points history;
+    history.reserve(header.historySize);
+    const int columns = static_cast<int>(header.columns);
+    for (size_t i = 0; i < header.historySize; ++i) {
+        std::uint32_t cell;
+        std::memcpy(&cell, body + cellsSize + i * sizeof(cell),
+                    sizeof(cell));
+        history.push_back(Point(static_cast<int>(cell % header.columns),
+                                static_cast<int>(cell / header.columns)));
+    }
+    if (!engine.restore(columns, static_cast<int>(header.rows), palette,
+                        body, header.score, header.seed,
+                        std::move(history)))
+        return false;
+    Randomizer::State state;
+    std::copy(header.randomizer, header.randomizer + state.size(),
+              state.begin());
+    Randomizer randomizer;
+    randomizer.setState(state);
+    engine.setRandomizer(randomizer);
+    selected = Point(header.selectedX, header.selectedY);
+    return true;
+}
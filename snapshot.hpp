@@ -0,0 +1,26 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    A snapshot saves an in-progress game exactly as it stands so that it
+    can be resumed without replaying its moves. The file is a fixed-layout
+    header followed by the cells (one byte each, row-major, padded to a
+    multiple of four bytes) and the history (one u32 row-major cell index
+    per click). It is read by memory-mapping it, so even a huge board
+    resumes at memory speed, and it is only accepted if its checksum, byte
+    order, version, and sizes all match.
+*/
+
+#include "engine.hpp"
+
+#include <string>
+
+
+const std::uint32_t SNAPSHOT_VERSION = 1;
+
+
+bool saveSnapshot(const std::string& filename, const Engine& engine,
+                  const Point& selected);
+bool loadSnapshot(const std::string& filename, Engine& engine,
+                  Point& selected);
@@ -0,0 +1,70 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    Solves one deal: scons gravitate-solve && ./gravitate-solve
+        [columns [rows [maxColors [seed [maxNodes]]]]]
+    The result is printed as a CSV header and line; the winning and best
+    lines are printed to stderr as x,y moves. maxNodes defaults to
+    MAX_NODES_DEFAULT so that every run finishes in seconds; 0 means no
+    limit. Whether a board can be won is usually proven well within the
+    limit, but the highest score rarely is on boards as big as 9 x 9, so
+    if proven is 0 a warning says that max_score is only the best found.
+*/
+
+#include "solver.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+
+namespace {
+
+const long long MAX_NODES_DEFAULT = 1000000; // About 4-6s on 9 x 9
+
+
+void printLine(const char* name, const Points& line) {
+    std::fprintf(stderr, "%s:", name);
+    for (const auto& point: line)
+        std::fprintf(stderr, " %d,%d", point.x, point.y);
+    std::fprintf(stderr, "\n");
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[]) {
+    const int columns = argc > 1 ? std::atoi(argv[1]) : 9;
+    const int rows = argc > 2 ? std::atoi(argv[2]) : 9;
+    const int maxColors = argc > 3 ? std::atoi(argv[3]) : 4;
+    const unsigned seed = argc > 4
+        ? static_cast<unsigned>(std::strtoul(argv[4], nullptr, 10))
+        : std::random_device{}();
+    const long long maxNodes = argc > 5 ? std::atoll(argv[5])
+                                      : MAX_NODES_DEFAULT;
+    if (columns < 1 || rows < 1 || maxColors < 2 ||
+            maxColors > PALETTE_SIZE || maxNodes < 0) {
+        std::fprintf(stderr, "usage: gravitate-solve [columns [rows "
+                     "[maxColors [seed [maxNodes]]]]]\n");
+        return 2;
+    }
+    Engine engine;
+    engine.newGame(columns, rows, maxColors, seed);
+    Solver solver;
+    const auto solution = solver.solve(engine, maxNodes);
+    const auto& stats = solution.stats;
+    std::printf("columns,rows,colors,seed,winnable,proven,max_score,nodes,"
+                "nodes_per_second,tt_hit_rate,seconds\n");
+    std::printf("%d,%d,%d,%u,%d,%d,%lld,%lld,%.0f,%.3f,%.3f\n", columns,
+                rows, maxColors, seed, solution.winnable, solution.proven,
+                static_cast<long long>(solution.maxScore), stats.nodes,
+                stats.nodesPerSecond(), stats.hitRate(), stats.seconds);
+    printLine("winning", solution.winningLine);
+    printLine("best", solution.bestLine);
+    if (!solution.proven)
+        std::fprintf(stderr, "unproven: stopped after %lld nodes, so "
+                     "max_score is the best found, not the best possible%s"
+                     "\n", stats.nodes, solution.winnable
+                     ? "" : ", and whether the board can be won is unknown");
+}
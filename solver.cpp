@@ -0,0 +1,288 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include "solver.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const Score SCORE_MAX = std::numeric_limits<Score>::max();
+const Score VALUE_MAX = (Score(1) << 61) - 1; // What an entry can hold
+const int BOUND_BITS = 2;
+
+Score add(Score a, Score b) {
+    return a > SCORE_MAX - b ? SCORE_MAX : a + b;
+}
+
+
+Score multiply(Score a, Score b) {
+    return b && a > SCORE_MAX / b ? SCORE_MAX : a * b;
+}
+
+
+// Mixed (splitmix64) into every table key since the engine's hash only
+// covers the cells, yet the same cells on another board shape, or with
+// another color count, can have another outcome and score
+std::uint64_t configurationKey(const Engine& engine) {
+    std::uint64_t z = (static_cast<std::uint64_t>(engine.columns()) << 40 |
+                       static_cast<std::uint64_t>(engine.rows()) << 16 |
+                       static_cast<std::uint64_t>(engine.maxColors())) +
+                      0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+} // namespace
+
+
+TranspositionTable::TranspositionTable(int bits)
+        : slots(new Slot[std::size_t(1) << bits]),
+          mask((std::uint64_t(1) << bits) - 1) {
+    clear();
+}
+
+
+void TranspositionTable::clear() {
+    for (std::uint64_t i = 0; i <= mask; ++i) {
+        slots[i].check.store(0, std::memory_order_relaxed);
+        slots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+
+bool TranspositionTable::probe(std::uint64_t key, Entry& entry) const {
+    const auto& slot = slots[key & mask];
+    const auto data = slot.data.load(std::memory_order_relaxed);
+    const auto check = slot.check.load(std::memory_order_relaxed);
+    const auto bound = static_cast<Bound>(data & ((1 << BOUND_BITS) - 1));
+    if ((check ^ data) != key || bound == NONE)
+        return false;
+    entry.bound = bound;
+    entry.value = static_cast<Score>(data >> BOUND_BITS);
+    return true;
+}
+
+
+// Always replaces: the newest boards are the likeliest to be seen again
+void TranspositionTable::store(std::uint64_t key, const Entry& entry) {
+    auto& slot = slots[key & mask];
+    const auto data = (static_cast<std::uint64_t>(
+        std::min(entry.value, VALUE_MAX)) << BOUND_BITS) | entry.bound;
+    slot.data.store(data, std::memory_order_relaxed);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+
+// maxNodes of 0 means no limit
+Solution Solver::solve(const Engine& engine, long long maxNodes_) {
+    const auto start = Clock::now();
+    setUp(engine, maxNodes_);
+    solution.winnable = canWin(0);
+    if (solution.winnable) {
+        solution.winningLine = line;
+        for (size_t i = 0; i < line.size(); ++i)
+            game.undo();
+    }
+    table.clear();
+    line.clear();
+    solution.maxScore = engine.score();
+    playOut(engine, false);
+    playOut(engine, true);
+    maximize(0);
+    solution.proven = !isStopped();
+    solution.stats.seconds = std::chrono::duration<double>(
+        Clock::now() - start).count();
+    return solution;
+}
+
+
+// Only proves whether the board can be cleared, which is usually far
+// quicker than finding the highest score, so maxScore is left as the
+// current score and bestLine is empty. A win found within maxNodes is
+// always proven.
+Solution Solver::prove(const Engine& engine, long long maxNodes_) {
+    const auto start = Clock::now();
+    setUp(engine, maxNodes_);
+    solution.winnable = canWin(0);
+    if (solution.winnable)
+        solution.winningLine = line;
+    solution.proven = solution.winnable || !isStopped();
+    solution.maxScore = engine.score();
+    solution.stats.seconds = std::chrono::duration<double>(
+        Clock::now() - start).count();
+    return solution;
+}
+
+
+void Solver::setUp(const Engine& engine, long long maxNodes_) {
+    solution = Solution();
+    maxNodes = maxNodes_;
+    const int cells = engine.columns() * engine.rows();
+    // A color of n tiles can score most either as one group or as one
+    // group and as many pairs as possible, since the score is convex in
+    // the group size and every group also scores the same base amount
+    colorBounds.assign(cells + 1, 0);
+    for (int n = 2; n <= cells; ++n) {
+        const int pairs = n / 2 - 1;
+        colorBounds[n] = std::max(
+            engine.groupScore(n),
+            add(engine.groupScore(n - 2 * pairs),
+                multiply(pairs, engine.groupScore(2))));
+    }
+    const int depths = cells / 2 + 2;
+    moves.assign(depths, Points());
+    game = engine;
+    game.setUndoable(true); // The caller's engine might not be
+    configuration = configurationKey(engine);
+    line.clear();
+}
+
+
+// On success the line is left holding the winning moves, and the game is
+// left at its end
+bool Solver::canWin(int depth) {
+    ++solution.stats.nodes;
+    if (game.state() == GameState::Won)
+        return true;
+    if (game.state() != GameState::Playing || isStopped())
+        return false;
+    const auto hash = game.hash() ^ configuration;
+    TranspositionTable::Entry entry;
+    ++solution.stats.probes;
+    if (table.probe(hash, entry)) {
+        ++solution.stats.hits;
+        if (entry.bound == TranspositionTable::LOSS)
+            return false;
+    }
+    orderedMoves(depth);
+    for (const auto& move: moves[depth]) {
+        game.apply(move, false);
+        line.push_back(move);
+        if (canWin(depth + 1))
+            return true;
+        line.pop_back();
+        game.undo();
+    }
+    if (!isStopped()) // Else not every move was tried
+        table.store(hash, {TranspositionTable::LOSS, 0});
+    return false;
+}
+
+
+// Plays a quick greedy game to its end so that maximize() starts with a
+// score to beat and cuts off far more. Largest groups are played first;
+// if tabu, the commonest color is left until it is the only choice, so
+// that its tiles gather into one big, high-scoring group.
+void Solver::playOut(const Engine& engine, bool tabu) {
+    Engine playout = engine;
+    playout.setUndoable(false);
+    Points played;
+    Points legal;
+    while (playout.state() == GameState::Playing) {
+        int tabuColor = tabu ? 1 : NO_COLOR;
+        if (tabu)
+            for (int color = 2; color <= playout.maxColors(); ++color)
+                if (playout.colorCount(color) >
+                        playout.colorCount(tabuColor))
+                    tabuColor = color;
+        legal.clear();
+        playout.legalMoves(legal);
+        Point best;
+        int bestSize = 0;
+        for (const auto& move: legal) {
+            const int size = playout.groupSize(move) +
+                (playout.grid().at(move.x, move.y) == tabuColor
+                 ? 0 : playout.rows() * playout.columns());
+            if (size > bestSize) {
+                best = move;
+                bestSize = size;
+            }
+        }
+        playout.apply(best, false);
+        played.push_back(best);
+    }
+    if (playout.score() > solution.maxScore) {
+        solution.maxScore = playout.score();
+        solution.bestLine = played;
+    }
+}
+
+
+// Returns the most that the rest of the game can score. A subtree is cut
+// off once even its bound can't beat the best final score found so far;
+// the result is then only an upper bound.
+Solver::Result Solver::maximize(int depth) {
+    ++solution.stats.nodes;
+    const Score score = game.score();
+    if (game.state() != GameState::Playing) {
+        if (score > solution.maxScore) {
+            solution.maxScore = score;
+            solution.bestLine = line;
+        }
+        return {0, true};
+    }
+    const Score upper = bound(game);
+    const Score needed = solution.maxScore - score; // To beat
+    if (upper <= needed || isStopped())
+        return {upper, false};
+    const auto hash = game.hash() ^ configuration;
+    TranspositionTable::Entry entry;
+    ++solution.stats.probes;
+    if (table.probe(hash, entry)) {
+        ++solution.stats.hits;
+        if (entry.value <= needed) // An exact value still needs its line
+            return {entry.value, entry.bound == TranspositionTable::EXACT};
+    }
+    orderedMoves(depth);
+    Result result{0, true};
+    for (const auto& move: moves[depth]) {
+        game.apply(move, false);
+        const Score delta = game.score() - score;
+        line.push_back(move);
+        const auto childResult = maximize(depth + 1);
+        line.pop_back();
+        game.undo();
+        result.value = std::max(result.value,
+                                add(delta, childResult.value));
+        result.exact = result.exact && childResult.exact;
+    }
+    if (!isStopped())
+        table.store(hash,
+                    {result.exact ? TranspositionTable::EXACT
+                                  : TranspositionTable::UPPER,
+                     result.value});
+    return result;
+}
+
+
+// The most the rest of the game could possibly score
+Score Solver::bound(const Engine& engine) const {
+    Score total = 0;
+    for (int color = 1; color <= engine.maxColors(); ++color)
+        total = add(total, colorBounds[engine.colorCount(color)]);
+    return total;
+}
+
+
+// Largest groups first
+void Solver::orderedMoves(int depth) {
+    auto& depthMoves = moves[depth];
+    depthMoves.clear();
+    game.legalMoves(depthMoves);
+    std::stable_sort(depthMoves.begin(), depthMoves.end(),
+                     [&](const Point& a, const Point& b) {
+        return game.groupSize(a) > game.groupSize(b);
+    });
+}
+
+
+bool Solver::isStopped() {
+    return maxNodes && solution.stats.nodes >= maxNodes;
+}
@@ -0,0 +1,115 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    An exact solver for small and medium boards with no wx dependency. A
+    depth-first search first proves whether the board can be cleared, and
+    then a branch-and-bound search finds the highest final score that can
+    be reached, whether or not the game is won; prove() only does the
+    first, which is usually far quicker. The score search starts from
+    the better of two greedy playouts so that it can cut off early, but
+    its bound (each color cleared as one group) is loose, so on boards
+    as big as 9 x 9 it rarely finishes within a node limit. Moves are
+    tried largest group first, and are made and unmade on a single engine
+    with apply() and undo(). Boards seen before are looked up by the
+    engine's Zobrist hash, mixed with the board size and color count, in
+    a fixed-size transposition table whose entries are written and read
+    without locks, so several solvers may share one, and one solver may
+    be reused for boards of any size.
+*/
+
+#include "engine.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+// Each slot holds a key and its data; the key is stored XORed with the
+// data so that a torn write by another thread reads as a miss
+class TranspositionTable {
+public:
+    enum Bound { NONE, EXACT, UPPER, LOSS };
+
+    struct Entry {
+        Bound bound = NONE;
+        Score value = 0; // The most the rest of the game can score
+    };
+
+    explicit TranspositionTable(int bits=20);
+
+    void clear();
+    bool probe(std::uint64_t key, Entry& entry) const;
+    void store(std::uint64_t key, const Entry& entry);
+
+    int size() const { return static_cast<int>(mask + 1); }
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> check;
+        std::atomic<std::uint64_t> data;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::uint64_t mask;
+};
+
+
+struct SolverStats {
+    double nodesPerSecond() const {
+        return seconds > 0 ? nodes / seconds : 0;
+    }
+    double hitRate() const {
+        return probes ? static_cast<double>(hits) / probes : 0;
+    }
+
+    long long nodes = 0;
+    long long probes = 0; // Transposition table lookups
+    long long hits = 0; // Lookups that found the board
+    double seconds = 0; // How long the proof took
+};
+
+
+struct Solution {
+    bool winnable = false;
+    bool proven = false; // False if the node limit stopped the search
+    Score maxScore = 0; // The final score of the best line
+    Points winningLine; // The moves of a won game, if there is one
+    Points bestLine; // The moves that reach maxScore
+    SolverStats stats;
+};
+
+
+class Solver {
+public:
+    explicit Solver(int tableBits=20)
+        : table(tableBits), game(0), configuration(0) {}
+
+    Solution solve(const Engine& engine, long long maxNodes=0);
+    Solution prove(const Engine& engine, long long maxNodes=0);
+
+private:
+    struct Result {
+        Score value; // The most the rest of the game can score
+        bool exact; // Else value is only an upper bound
+    };
+
+    void setUp(const Engine& engine, long long maxNodes);
+    void playOut(const Engine& engine, bool tabu);
+    bool canWin(int depth);
+    Result maximize(int depth);
+    Score bound(const Engine& engine) const;
+    void orderedMoves(int depth);
+    bool isStopped();
+
+    TranspositionTable table;
+    Engine game; // Moves are made with apply() and unmade with undo()
+    std::vector<Points> moves; // The moves to try at each depth
+    Points line; // The moves made to reach the current depth
+    std::vector<Score> colorBounds; // By a color's tile count
+    Solution solution;
+    long long maxNodes;
+    std::uint64_t configuration; // XORed into every engine hash
+};
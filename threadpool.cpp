@@ -0,0 +1,106 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include "threadpool.hpp"
+
+#include <algorithm>
+
+
+namespace {
+
+// Which pool and worker the current thread is, if any
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local int currentWorker = -1;
+
+} // namespace
+
+
+ThreadPool::ThreadPool(int threads)
+        : queued(0), pending(0), next(0), stopping(false) {
+    if (threads <= 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < threads; ++i)
+        queues.push_back(std::make_unique<Queue>());
+    for (int i = 0; i < threads; ++i)
+        workers.emplace_back([this, i]() { run(i); });
+}
+
+
+// Tasks still queued are run before the workers finish
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    for (auto& worker: workers)
+        worker.join();
+}
+
+
+void ThreadPool::submit(Task task) {
+    const int worker = currentPool == this
+        ? currentWorker : static_cast<int>(next++ % queues.size());
+    ++pending;
+    {
+        std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+        queues[worker]->tasks.push_back(std::move(task));
+    }
+    ++queued;
+    { // So that a worker can't miss the wakeup between test and wait
+        std::lock_guard<std::mutex> lock(mutex);
+    }
+    wakeup.notify_one();
+}
+
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [&]() { return pending == 0; });
+}
+
+
+void ThreadPool::run(int worker) {
+    currentPool = this;
+    currentWorker = worker;
+    Task task;
+    while (true) {
+        if (pop(worker, task)) {
+            task();
+            task = nullptr;
+            if (--pending == 0) {
+                std::lock_guard<std::mutex> lock(mutex);
+                idle.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        wakeup.wait(lock, [&]() { return stopping || queued > 0; });
+        if (stopping && queued == 0)
+            return;
+    }
+}
+
+
+// Takes the newest task from the worker's own queue, or else steals the
+// oldest task from another worker's
+bool ThreadPool::pop(int worker, Task& task) {
+    const int count = static_cast<int>(queues.size());
+    for (int k = 0; k < count; ++k) {
+        auto& queue = *queues[(worker + k) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+        if (k == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        --queued;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,56 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    A fixed set of worker threads, each with its own queue of tasks. A
+    worker takes tasks from the back of its own queue and, when that is
+    empty, steals from the front of the others'. Tasks submitted by a
+    worker go on its own queue, so work that resubmits itself stays on the
+    same core while idle workers take whatever is left over.
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit ThreadPool(int threads=0); // 0 means one per core
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return static_cast<int>(workers.size()); }
+
+    void submit(Task task);
+    void wait(); // Until every task (including resubmitted ones) is done
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(int worker);
+    bool pop(int worker, Task& task);
+
+    std::vector<std::unique_ptr<Queue>> queues; // One per worker
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::condition_variable idle;
+    std::atomic<int> queued; // Tasks waiting in the queues
+    std::atomic<int> pending; // Tasks queued or running
+    std::atomic<unsigned> next; // Where the next outside task goes
+    bool stopping;
+};
@@ -0,0 +1,123 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include "tilecache.hpp"
+
+#include <wx/dcmemory.h>
+
+#include <algorithm>
+
+
+namespace {
+
+const int FOCUSES = 2;
+
+} // namespace
+
+
+void TileCache::setPalette(const PaletteIndexes& indexes) {
+    palette.reset(indexes);
+    clear();
+}
+
+
+void TileCache::setSize(int width_, int height_) {
+    if (width_ != width || height_ != height) {
+        width = width_;
+        height = height_;
+        clear();
+    }
+}
+
+
+// color may be NO_COLOR for an empty cell
+const wxBitmap& TileCache::get(int color, TileLook look, bool focused) {
+    if (sprites.empty())
+        sprites.resize((MAX_COLOR_INDEX + 1) * TILE_LOOKS * FOCUSES);
+    const size_t i = (color * TILE_LOOKS + static_cast<int>(look)) *
+                     FOCUSES + focused;
+    if (!sprites[i].IsOk())
+        sprites[i] = render(color, look, focused);
+    return sprites[i];
+}
+
+
+// Blits the given rectangle of cells; each tile is drawn at its board
+// pixel position less origin
+void TileCache::paint(wxDC& dc, const Grid& tiles, const wxRect& cells,
+                      const wxPoint& origin, bool gameOver,
+                      const Point& focus) {
+    for (int y = cells.GetTop(); y <= cells.GetBottom(); ++y)
+        for (int x = cells.GetLeft(); x <= cells.GetRight(); ++x) {
+            const auto cell = tiles.at(x, y);
+            const auto look = (cell & DIMMED) ? TileLook::Dimmed
+                              : gameOver ? TileLook::GameOver
+                              : (cell & HINTED) ? TileLook::Hinted
+                              : TileLook::Normal;
+            const bool focused = focus.x == x && focus.y == y;
+            dc.DrawBitmap(get(cell & COLOR_MASK, look, focused),
+                          x * width - origin.x, y * height - origin.y);
+        }
+}
+
+
+wxBitmap TileCache::render(int color, TileLook look, bool focused) const {
+    wxBitmap bitmap(std::max(1, width), std::max(1, height));
+    wxMemoryDC dc(bitmap);
+    dc.SetBackground(wxBrush(BACKGROUND_COLOR));
+    dc.Clear();
+    if (color == NO_COLOR)
+        return bitmap;
+    auto gc = wxGraphicsContext::Create(dc);
+    if (gc) {
+        const double edge = std::min(width, height) / 9.0;
+        const double edge2 = edge * 2.0;
+        const auto& colorPair = palette.get(color, look);
+        drawSegments(gc, edge, colorPair, 0, 0, width, height);
+        auto brush = gc->CreateLinearGradientBrush(
+            0, 0, width, height, colorPair.light, colorPair.dark);
+        gc->SetBrush(brush);
+        gc->DrawRectangle(edge, edge, width - edge2, height - edge2);
+        if (focused)
+            drawFocus(gc, 0, 0, edge, width, height);
+        delete gc;
+    }
+    return bitmap;
+}
+
+
+void TileCache::drawSegments(wxGraphicsContext* gc, double edge,
+                             const ColorPair& colorPair, double x1,
+                             double y1, double x2, double y2) const {
+    drawSegment(gc, colorPair.light, {{x1, y1}, {x1 + edge, y1 + edge},
+                {x2 - edge, y1 + edge}, {x2, y1}});
+    drawSegment(gc, colorPair.light, {{x1, y1}, {x1, y2},
+                {x1 + edge, y2 - edge}, {x1 + edge, y1 + edge}});
+    drawSegment(gc, colorPair.dark, {{x2 - edge, y1 + edge}, {x2, y1},
+                {x2, y2}, {x2 - edge, y2 - edge}});
+    drawSegment(gc, colorPair.dark, {{x1, y2}, {x1 + edge, y2 - edge},
+                {x2 - edge, y2 - edge}, {x2, y2}});
+}
+
+
+void TileCache::drawSegment(wxGraphicsContext* gc, const wxColour& color,
+                            const Coords& coords) const {
+    auto path = gc->CreatePath();
+    path.MoveToPoint(coords[0][0], coords[0][1]);
+    for (int i = 1; i < COORDS_LEN; ++i)
+        path.AddLineToPoint(coords[i][0], coords[i][1]);
+    path.CloseSubpath();
+    gc->SetBrush(wxBrush(color));
+    gc->FillPath(path);
+}
+
+
+void TileCache::drawFocus(wxGraphicsContext* gc, double x1, double y1,
+                          double edge, double width, double height) const {
+    gc->SetBrush(wxBrush());
+    edge *= 4 / 3;
+    const double edge2 = edge * 2;
+    gc->SetPen(wxPen(*wxBLACK, 1, wxPENSTYLE_DOT));
+    gc->DrawRectangle(x1 + edge, y1 + edge, width - edge2, height - edge2);
+    gc->SetPen(wxPen());
+}
@@ -0,0 +1,50 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    Every look a tile can have (each color, normal, dimmed, game over or
+    hinted, with or without the focus rectangle) is rendered once per tile
+    size into a bitmap, so painting the board is just a matter of
+    blitting. The cache empties itself whenever the tile size or palette
+    changes.
+*/
+
+#include "boardutil.hpp"
+
+#include <wx/wxprec.h>
+#ifndef WX_PRECOMP
+    #include <wx/wx.h>
+#endif
+#include <wx/graphics.h>
+
+#include <vector>
+
+
+class TileCache {
+public:
+    TileCache() : width(0), height(0) {}
+
+    void setPalette(const PaletteIndexes& indexes);
+    void setSize(int width, int height);
+    void clear() { sprites.clear(); }
+
+    const wxBitmap& get(int color, TileLook look, bool focused);
+    void paint(wxDC& dc, const Grid& tiles, const wxRect& cells,
+               const wxPoint& origin, bool gameOver, const Point& focus);
+
+private:
+    wxBitmap render(int color, TileLook look, bool focused) const;
+    void drawSegments(wxGraphicsContext* gc, double edge,
+                      const ColorPair& colorPair, double x1, double y1,
+                      double x2, double y2) const;
+    void drawSegment(wxGraphicsContext* gc, const wxColour& color,
+                     const Coords& coords) const;
+    void drawFocus(wxGraphicsContext* gc, double x1, double y1, double edge,
+                   double width, double height) const;
+
+    TilePalette palette;
+    int width;
+    int height;
+    std::vector<wxBitmap> sprites; // Rendered on demand
+};
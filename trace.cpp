@@ -0,0 +1,173 @@
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+#include "trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+
+std::atomic<bool> traceEnabled(false);
+
+
+namespace {
+
+struct Event {
+    const char* name;
+    std::int64_t start;
+    std::int64_t duration;
+};
+
+
+// Incremented by every startTrace(); a buffer whose generation is older
+// holds only events from before, which its thread drops when it next
+// records, so no thread ever resets another's buffer
+std::atomic<std::uint32_t> generation(0);
+
+
+// Only its own thread writes to a buffer, like a seqlock: begun is
+// advanced before a slot is overwritten and count after it is written.
+// The slots are atomic so that writeTrace() can read them while their
+// thread still records (e.g., a worker that was busy at stopTrace()),
+// and it keeps only the events that begun shows weren't overwritten
+// while it read them. Events from first on belong to this generation.
+struct Buffer {
+    struct Slot {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<std::int64_t> start{0};
+        std::atomic<std::int64_t> duration{0};
+    };
+
+    explicit Buffer(int thread_) : thread(thread_) {}
+
+    int thread; // A small number to identify the thread in the output
+    std::atomic<std::uint32_t> generation{0};
+    std::atomic<std::uint64_t> first{0};
+    std::atomic<std::uint64_t> begun{0};
+    std::atomic<std::uint64_t> count{0}; // Events ever recorded
+    Slot slots[TRACE_BUFFER_SIZE];
+};
+
+
+// Buffers are only added, never freed, so a thread's pointer to its own
+// buffer stays valid even after a trace is written
+std::mutex mutex;
+std::vector<std::unique_ptr<Buffer>> buffers;
+
+
+Buffer* threadBuffer() {
+    thread_local Buffer* buffer = nullptr;
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock(mutex);
+        buffers.push_back(std::make_unique<Buffer>(
+            static_cast<int>(buffers.size()) + 1));
+        buffer = buffers.back().get();
+    }
+    return buffer;
+}
+
+
+// Appends the buffer's events of the current generation that are intact
+void copyEvents(const Buffer& buffer, std::uint32_t current,
+                std::vector<std::pair<int, Event>>& events) {
+    if (buffer.generation.load(std::memory_order_acquire) != current)
+        return;
+    const auto first = buffer.first.load(std::memory_order_relaxed);
+    const auto count = buffer.count.load(std::memory_order_acquire);
+    auto from = std::max(first, count > TRACE_BUFFER_SIZE
+                                ? count - TRACE_BUFFER_SIZE : 0);
+    const auto size = events.size();
+    for (auto i = from; i < count; ++i) {
+        const auto& slot = buffer.slots[i % TRACE_BUFFER_SIZE];
+        events.emplace_back(buffer.thread, Event{
+            slot.name.load(std::memory_order_relaxed),
+            slot.start.load(std::memory_order_relaxed),
+            slot.duration.load(std::memory_order_relaxed)});
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (buffer.generation.load(std::memory_order_relaxed) != current) {
+        events.resize(size); // A new trace has started
+        return;
+    }
+    // Event i's slot is reused by event i + TRACE_BUFFER_SIZE
+    const auto begun = buffer.begun.load(std::memory_order_relaxed);
+    if (begun > from + TRACE_BUFFER_SIZE) {
+        const auto torn = std::min(begun - TRACE_BUFFER_SIZE, count) - from;
+        events.erase(events.begin() + static_cast<std::ptrdiff_t>(size),
+                     events.begin() + static_cast<std::ptrdiff_t>(
+                         size + torn));
+    }
+}
+
+} // namespace
+
+
+void startTrace() {
+    generation.fetch_add(1, std::memory_order_release);
+    traceEnabled.store(true, std::memory_order_relaxed);
+}
+
+
+void stopTrace() {
+    traceEnabled.store(false, std::memory_order_relaxed);
+}
+
+
+// Times are in µs from the earliest event kept, as Chrome expects
+bool writeTrace(const std::string& filename) {
+    std::vector<std::pair<int, Event>> events; // By thread
+    {
+        const auto current = generation.load(std::memory_order_acquire);
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& buffer: buffers)
+            copyEvents(*buffer, current, events);
+    }
+    std::int64_t origin = std::numeric_limits<std::int64_t>::max();
+    for (const auto& event: events)
+        origin = std::min(origin, event.second.start);
+    auto file = std::fopen(filename.c_str(), "w");
+    if (!file)
+        return false;
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    const char* separator = "\n";
+    for (const auto& [thread, event]: events) {
+        std::fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,"
+                     "\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", separator,
+                     event.name, thread, (event.start - origin) / 1000.0,
+                     event.duration / 1000.0);
+        separator = ",\n";
+    }
+    std::fprintf(file, "\n]}\n");
+    return std::fclose(file) == 0;
+}
+
+
+std::int64_t TraceScope::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+void TraceScope::record(const char* name, std::int64_t start,
+                        std::int64_t duration) {
+    auto buffer = threadBuffer();
+    const auto count = buffer->count.load(std::memory_order_relaxed);
+    const auto current = generation.load(std::memory_order_acquire);
+    if (buffer->generation.load(std::memory_order_relaxed) != current) {
+        buffer->first.store(count, std::memory_order_relaxed);
+        buffer->generation.store(current, std::memory_order_release);
+    }
+    buffer->begun.store(count + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    auto& slot = buffer->slots[count % TRACE_BUFFER_SIZE];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.duration.store(duration, std::memory_order_relaxed);
+    buffer->count.store(count + 1, std::memory_order_release);
+}
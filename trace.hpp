@@ -0,0 +1,65 @@
+#pragma once
+// Copyright © 2020 Mark Summerfield. All rights reserved.
+// License: GPLv3
+
+/*
+    Lightweight tracing with no wx dependency, so that real sessions can
+    be profiled without a profiler attached. TRACE_SCOPE("name") times the
+    rest of its block; the name must be a string literal. Each thread
+    records into its own fixed-size ring buffer without locking, so the
+    oldest events are overwritten and a busy thread can't crowd out a
+    quiet one. Nothing is recorded until startTrace() is called, and until
+    then a trace point costs one relaxed atomic load. Building with
+    -DGRAVITATE_NO_TRACE removes every trace point. writeTrace() saves the
+    events as Chrome trace-event JSON (load it in chrome://tracing or
+    https://ui.perfetto.dev).
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+
+const int TRACE_BUFFER_SIZE = 1 << 15; // Events kept per thread
+
+extern std::atomic<bool> traceEnabled; // Use isTracing()
+
+
+void startTrace(); // Discards any events recorded before
+void stopTrace();
+inline bool isTracing() {
+    return traceEnabled.load(std::memory_order_relaxed);
+}
+bool writeTrace(const std::string& filename); // Best after stopTrace()
+
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name_)
+            : name(name_), start(isTracing() ? now() : -1) {}
+    ~TraceScope() {
+        if (start >= 0 && isTracing())
+            record(name, start, now() - start);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    static std::int64_t now(); // In ns
+    static void record(const char* name, std::int64_t start,
+                       std::int64_t duration);
+
+    const char* name;
+    std::int64_t start; // -1 if not tracing when the scope began
+};
+
+
+#ifdef GRAVITATE_NO_TRACE
+    #define TRACE_SCOPE(name)
+#else
+    #define TRACE_CONCAT_(a, b) a##b
+    #define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+    #define TRACE_SCOPE(name) \
+        const TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#endif
@@ -3,14 +3,52 @@
 
 #include "util.hpp"
 
-#include <iostream>
+#include <climits>
 #include <locale>
-#include <sstream>
 
 
-std::string humanize(const int i) {
-    std::ostringstream oss;
-    oss.imbue(std::locale(""));
-    oss << i;
-    return oss.str();
+namespace {
+
+// The user's locale is only looked up once since that is slow
+const std::numpunct<char>& punctuation() {
+    static const std::locale locale("");
+    return std::use_facet<std::numpunct<char>>(locale);
+}
+
+} // namespace
+
+
+// Groups the digits as the user's locale does, e.g., 1,234,567; builds
+// the result directly since this is called for every status update
+std::string humanize(const long long i) {
+    static const auto& punct = punctuation();
+    static const auto separator = punct.thousands_sep();
+    static const auto grouping = punct.grouping();
+    unsigned long long n = i < 0 ? 0ULL - static_cast<unsigned long long>(i)
+                                 : static_cast<unsigned long long>(i);
+    char digits[64]; // Filled from the end
+    char* p = digits + sizeof(digits);
+    // A group size of 0, less, or CHAR_MAX means no more separators; the
+    // last size repeats
+    auto groupSize = [&](size_t group) {
+        const int size = grouping[group];
+        return size > 0 && size != CHAR_MAX ? size : -1;
+    };
+    size_t group = 0;
+    int left = grouping.empty() ? -1 : groupSize(0); // Until a separator
+    do {
+        if (left == 0) {
+            *--p = separator;
+            if (group + 1 < grouping.size())
+                ++group;
+            left = groupSize(group);
+        }
+        *--p = static_cast<char>('0' + n % 10);
+        n /= 10;
+        if (left > 0)
+            --left;
+    } while (n);
+    if (i < 0)
+        *--p = '-';
+    return std::string(p, digits + sizeof(digits));
 }
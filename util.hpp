@@ -5,4 +5,4 @@
 #include <string>
 
 
-std::string humanize(const int i);
+std::string humanize(const long long i);